@@ -0,0 +1,80 @@
+#include "animation.h"
+#include <assert.h>
+#include <time.h>
+#include <algorithm>
+
+double
+MonotonicClock::Now()
+{
+	struct timespec oTime;
+	clock_gettime(CLOCK_MONOTONIC, &oTime);
+	return oTime.tv_sec + oTime.tv_nsec / 1000000000.0;
+}
+
+Animation::Animation()
+	: m_fDuration(0.0f), m_fElapsed(0.0f), m_bRunning(false), m_pEasing(Easing::Linear)
+{
+}
+
+void
+Animation::Start(float fDuration, Easing::TFunction pEasing)
+{
+	assert(fDuration > 0.0f);
+	m_fDuration = fDuration;
+	m_fElapsed = 0.0f;
+	m_bRunning = true;
+	m_pEasing = pEasing;
+}
+
+void
+Animation::Advance(float fSeconds)
+{
+	if (!m_bRunning)
+		return;
+
+	m_fElapsed += fSeconds;
+	if (m_fElapsed >= m_fDuration) {
+		m_fElapsed = m_fDuration;
+		m_bRunning = false;
+	}
+}
+
+float
+Animation::GetProgress(float fAhead) const
+{
+	if (m_fDuration <= 0.0f)
+		return 0.0f;
+	float fElapsed = m_bRunning ? m_fElapsed + fAhead : m_fElapsed;
+	return m_pEasing(std::min(fElapsed / m_fDuration, 1.0f));
+}
+
+Timer::Timer()
+	: m_fInterval(0.0f), m_fRemaining(0.0f), m_bRunning(false)
+{
+}
+
+void
+Timer::Start(float fInterval)
+{
+	assert(fInterval > 0.0f);
+	m_fInterval = fInterval;
+	m_fRemaining = fInterval;
+	m_bRunning = true;
+}
+
+int
+Timer::Advance(float fSeconds)
+{
+	if (!m_bRunning)
+		return 0;
+
+	int iNumFired = 0;
+	m_fRemaining -= fSeconds;
+	while (m_fRemaining <= 0.0f) {
+		m_fRemaining += m_fInterval;
+		iNumFired++;
+	}
+	return iNumFired;
+}
+
+/* vim:set ts=2 sw=2: */
@@ -0,0 +1,117 @@
+#ifndef __ANIMATION_H__
+#define __ANIMATION_H__
+
+/*
+ * Everything needed to animate in terms of time rather than frames; the
+ * animations and timers are advanced by the step length passed to
+ * IRunnable::Update(), so they run at the same pace at any update rate.
+ */
+
+//! \brief Clock which never jumps, unlike the time of day
+class MonotonicClock
+{
+public:
+	//! \brief Retrieve the number of seconds since some arbitrary moment
+	static double Now();
+};
+
+/*! \brief Easing curves
+ *
+ *  These map linear progress in [0, 1] to eased progress in [0, 1].
+ */
+class Easing
+{
+public:
+	typedef float (*TFunction)(float fProgress);
+
+	static float Linear(float fProgress) { return fProgress; }
+	static float EaseIn(float fProgress) { return fProgress * fProgress; }
+	static float EaseOut(float fProgress) { return fProgress * (2.0f - fProgress); }
+	static float EaseInOut(float fProgress) { return fProgress * fProgress * (3.0f - 2.0f * fProgress); }
+};
+
+/*! \brief Progress of something happening over a fixed amount of time
+ *
+ *  Once started, the animation runs until its duration has passed.
+ */
+class Animation
+{
+public:
+	//! \brief Constructs an animation which is not running
+	Animation();
+
+	/*! \brief Starts the animation from the beginning
+	 *  \param fDuration Duration, in seconds
+	 *  \param pEasing Easing curve to apply to the progress
+	 */
+	void Start(float fDuration, Easing::TFunction pEasing = Easing::Linear);
+
+	//! \brief Stops the animation where it is
+	void Stop() { m_bRunning = false; }
+
+	//! \brief Is the animation running?
+	bool IsRunning() const { return m_bRunning; }
+
+	/*! \brief Advances the animation
+	 *  \param fSeconds Time passed
+	 *
+	 *  The animation stops once its duration has passed.
+	 */
+	void Advance(float fSeconds);
+
+	/*! \brief Retrieve the eased progress
+	 *  \param fAhead Number of seconds to look ahead, i.e. to interpolate
+	 *  \returns Progress, from 0 at the start to 1 at the end
+	 */
+	float GetProgress(float fAhead = 0.0f) const;
+
+private:
+	//! \brief Duration, in seconds
+	float m_fDuration;
+
+	//! \brief Time passed since the start, in seconds
+	float m_fElapsed;
+
+	//! \brief Is the animation running?
+	bool m_bRunning;
+
+	//! \brief Easing curve
+	Easing::TFunction m_pEasing;
+};
+
+//! \brief Fires at a fixed interval
+class Timer
+{
+public:
+	//! \brief Constructs a timer which is not running
+	Timer();
+
+	/*! \brief Starts the timer
+	 *  \param fInterval Interval, in seconds
+	 */
+	void Start(float fInterval);
+
+	//! \brief Stops the timer
+	void Stop() { m_bRunning = false; }
+
+	//! \brief Is the timer running?
+	bool IsRunning() const { return m_bRunning; }
+
+	/*! \brief Advances the timer
+	 *  \param fSeconds Time passed
+	 *  \returns Number of times the interval passed, 0 if not running
+	 */
+	int Advance(float fSeconds);
+
+private:
+	//! \brief Interval, in seconds
+	float m_fInterval;
+
+	//! \brief Time until the timer fires next, in seconds
+	float m_fRemaining;
+
+	//! \brief Is the timer running?
+	bool m_bRunning;
+};
+
+#endif /* __ANIMATION_H__ */
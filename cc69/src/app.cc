@@ -3,25 +3,40 @@
 #include <SDL/SDL.h>
 #include <SDL/SDL_ttf.h>
 #include <SDL/SDL_mixer.h>
+#include <algorithm>
 #include <assert.h>
 #include <err.h>
 #include <getopt.h>
 #include <iostream>
+#include <boost/thread.hpp>
+#include "benchmark.h"
 #include "clock.h"
 #include "events.h"
+#include "framescheduler.h"
 //#include "extra.h"
 #include "game.h"
+#include "glextensions.h"
+#include "glyphcache.h"
 #include "menu.h"
 #include "imagelibrary.h"
 #include "photoviewer.h"
+#include "pixelbufferpool.h"
+#include "sharedcontext.h"
+#include "spritebatch.h"
+#include "texturepool.h"
+#include "texture.h"
+#include "windowskin.h"
 //#include "musicplayer.h"
 
 App g_oApp;
 
 App::App()
-	: m_iDesiredFPS(60), m_poEvents(NULL), m_poPhotoViewer(NULL), m_poGame(NULL),
+	: m_poEvents(NULL), m_poSpriteBatch(NULL), m_poGlyphCache(NULL), m_poWindowSkin(NULL),
+		m_poPhotoViewer(NULL), m_poGame(NULL),
 	  m_poMenu(NULL), m_poClock(NULL), m_poMusicPlayer(NULL), m_poExtra(NULL),
-		m_poCurrentApp(NULL)
+		m_poCurrentApp(NULL), m_poFrameScheduler(NULL), m_iDesiredFPS(60), m_iNumDecodeWorkers(0),
+		m_iSystemCacheSize(128), m_iVideoCacheSize(64), m_iUploadBudget(4), m_bSharedContexts(false),
+		m_bVerbose(false), m_bBenchmark(false), m_bVSync(true)
 {
 }
 
@@ -34,15 +49,26 @@ App::~App()
 	assert(m_poImageLibrary == NULL);
 	assert(m_poMusicPlayer == NULL);
 	assert(m_poEvents == NULL);
+	assert(m_poSpriteBatch == NULL);
+	assert(m_poGlyphCache == NULL);
+	assert(m_poWindowSkin == NULL);
+	assert(m_poFrameScheduler == NULL);
 }
 
 void
 App::Usage()
 {
-	std::cerr << "usage: cc69 [-h?] [-s h,w] [-g device] -d datapath path ...\n";
+	std::cerr << "usage: cc69 [-h?vbln] [-s h,w] [-g device] [-w workers] [-c ram,vram] [-u ms] -d datapath path ...\n";
 	std::cerr << " -h, -?          this help\n";
 	std::cerr << " -s h,w          override window size to h x w (defaults to full screen)\n";
 	std::cerr << " -g device       gateware device to use\n";
+	std::cerr << " -w workers      number of image decode threads (defaults to one per CPU)\n";
+	std::cerr << " -c ram,vram     image cache size in MB of system/video memory (defaults to 128,64)\n";
+	std::cerr << " -u ms           time spent uploading images per frame (defaults to 4)\n";
+	std::cerr << " -l              upload images from the decode threads using shared contexts\n";
+	std::cerr << " -n              don't wait for the vertical retrace\n";
+	std::cerr << " -v              report performance statistics\n";
+	std::cerr << " -b              run the benchmarks and exit; no paths are needed\n";
 	std::cerr << " -d datapath     directory containing application data\n";
 	std::cerr << "\n";
 	std::cerr << "path ... is the list of directories containing photo's\n";
@@ -52,6 +78,13 @@ App::Usage()
 void
 App::Init(int argc, char** argv)
 {
+	/*
+	 * The decode threads may use X11 through their own OpenGL contexts; this
+	 * must be enabled before SDL touches X11, so before we know whether
+	 * that will happen. It is cheap enough to always do.
+	 */
+	SharedContext::InitThreads();
+
 	// Kickstart SDL and the image library
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_VIDEO) < 0)
 		errx(1, "cannot initialize video: %s", SDL_GetError());
@@ -72,7 +105,7 @@ App::Init(int argc, char** argv)
 	// Parse the commandline options
 	std::string sGatewareDevice;
 	int c;
-	while ((c = getopt(argc, argv, "?hg:s:d:")) != -1) {
+	while ((c = getopt(argc, argv, "?hvblng:s:d:w:c:u:")) != -1) {
 		switch(c) {
 			case 'h':
 			case '?':
@@ -90,16 +123,67 @@ App::Init(int argc, char** argv)
 				m_iHeight = h; m_iWidth = w;
 				break;
 			}
+			case 'c': {
+				char* ptr;
+				int ram = strtol(optarg, &ptr, 10);
+				int vram = *ptr == ',' ? strtol(ptr + 1, &ptr, 10) : 0;
+				if (ram <= 0 || vram <= 0 || *ptr != '\0') {
+					std::cerr << "error: cannot parse cache size\n";
+					Usage();
+					/* NOTREACHED */
+				}
+				m_iSystemCacheSize = ram; m_iVideoCacheSize = vram;
+				break;
+			}
 			case 'd':
 				m_sDataPath = optarg;
 				break;
 			case 'g':
 				sGatewareDevice = optarg;
 				break;
+			case 'v':
+				m_bVerbose = true;
+				break;
+			case 'b':
+				m_bBenchmark = true;
+				break;
+			case 'l':
+				m_bSharedContexts = true;
+				break;
+			case 'n':
+				m_bVSync = false;
+				break;
+			case 'u': {
+				char* ptr;
+				m_iUploadBudget = strtol(optarg, &ptr, 10);
+				if (m_iUploadBudget <= 0 || *ptr != '\0') {
+					std::cerr << "error: cannot parse upload time\n";
+					Usage();
+					/* NOTREACHED */
+				}
+				break;
+			}
+			case 'w': {
+				char* ptr;
+				m_iNumDecodeWorkers = strtol(optarg, &ptr, 10);
+				if (m_iNumDecodeWorkers <= 0 || *ptr != '\0') {
+					std::cerr << "error: cannot parse number of workers\n";
+					Usage();
+					/* NOTREACHED */
+				}
+				break;
+			}
 		}
 	}
 	argc -= optind;
 	argv += optind;
+
+	// The benchmarks only need OpenGL; don't demand photo's, data or audio
+	if (m_bBenchmark) {
+		InitVideo(info->vfmt->BitsPerPixel);
+		return;
+	}
+
 	if (argc == 0) {
 		std::cerr << "error: no paths to view\n";
 		Usage();
@@ -122,8 +206,12 @@ App::Init(int argc, char** argv)
 	m_poEvents = new Events();
 	m_poEvents->Init(sGatewareDevice);
 
-	// Create a new image library
-	m_poImageLibrary = new ImageLibrary();
+	// Create a new image library; by default, use a decode thread per CPU
+	if (m_iNumDecodeWorkers == 0)
+		m_iNumDecodeWorkers = std::max(1, (int)boost::thread::hardware_concurrency());
+	m_poImageLibrary = new ImageLibrary(m_iNumDecodeWorkers,
+	 (size_t)m_iSystemCacheSize * 1024 * 1024, (size_t)m_iVideoCacheSize * 1024 * 1024,
+	 m_iUploadBudget * 1000);
 
 	// Add the paths one by one
 	for (int i = 0; i < argc; i++) {
@@ -141,21 +229,46 @@ App::Init(int argc, char** argv)
 	if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0)
 		errx(1, "cannot set up audio: %s", Mix_GetError());
 
-	// Initialize our video mode
-	SDL_GL_SetAttribute( SDL_GL_DOUBLEBUFFER, 1 );
-	if (SDL_SetVideoMode(m_iWidth, m_iHeight, info->vfmt->BitsPerPixel, SDL_OPENGL) < 0)
-		errx(1, "cannot set video mode: %s", SDL_GetError());
+	InitVideo(info->vfmt->BitsPerPixel);
 
-	// Initialize the viewport and use a generic [0,0] .. [w,h] coordinate system
-	glViewport(0, 0, (GLsizei)m_iWidth, (GLsizei)m_iHeight);
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	glOrtho(0.0f, m_iWidth, m_iHeight, 0.0f, -1.0f, 1.0f);
-	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	// Frames are only paced by buffer swaps if the driver honoured our request
+	int iSwapControl = 0;
+	if (SDL_GL_GetAttribute(SDL_GL_SWAP_CONTROL, &iSwapControl) < 0 || iSwapControl != 1)
+		m_bVSync = false;
+	m_poFrameScheduler = new FrameScheduler(m_iDesiredFPS, m_bVSync);
 
-	// Reset the model view
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
+	// If requested, give every decode thread an OpenGL context of its own
+	if (m_bSharedContexts && !SharedContext::Init(m_iNumDecodeWorkers)) {
+		std::cerr << "warning: cannot create shared contexts, uploading from the main thread\n";
+		m_bSharedContexts = false;
+	}
+
+	/*
+	 * Otherwise, decoded photo's are streamed to the GPU using pixel buffers;
+	 * provide one for every image that may be preloaded and one for every
+	 * worker that may be decoding a replacement. Photo's are never larger
+	 * than the screen.
+	 */
+	if (!m_bSharedContexts)
+		PixelBufferPool::Init(ImageLibrary::GetMaximumPreloads() + m_iNumDecodeWorkers,
+		 Texture::CalculateDataSize(m_iWidth, m_iHeight));
+
+	// Everything is drawn using a sprite batch
+	m_poSpriteBatch = new SpriteBatch();
+
+	// Text is drawn from glyphs rasterized up front
+	m_poGlyphCache = new GlyphCache(m_pFont);
+	if (!m_poGlyphCache->Create()) {
+		std::cerr << "error: cannot rasterize font\n";
+		exit(EXIT_FAILURE);
+	}
+
+	// All windows share a single skin
+	m_poWindowSkin = new WindowSkin();
+	if (!m_poWindowSkin->Create()) {
+		std::cerr << "error: cannot create window skin\n";
+		exit(EXIT_FAILURE);
+	}
 
 	// Textures, flat shading and Z-buffering
 	glEnable(GL_TEXTURE_2D);
@@ -179,6 +292,30 @@ App::Init(int argc, char** argv)
 	SDL_ShowCursor(SDL_DISABLE);
 }
 
+void
+App::InitVideo(int iBitsPerPixel)
+{
+	// Initialize our video mode
+	SDL_GL_SetAttribute( SDL_GL_DOUBLEBUFFER, 1 );
+	SDL_GL_SetAttribute(SDL_GL_SWAP_CONTROL, m_bVSync ? 1 : 0);
+	if (SDL_SetVideoMode(m_iWidth, m_iHeight, iBitsPerPixel, SDL_OPENGL) < 0)
+		errx(1, "cannot set video mode: %s", SDL_GetError());
+
+	// Initialize the viewport and use a generic [0,0] .. [w,h] coordinate system
+	glViewport(0, 0, (GLsizei)m_iWidth, (GLsizei)m_iHeight);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0.0f, m_iWidth, m_iHeight, 0.0f, -1.0f, 1.0f);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+	// Reset the model view
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	// Figure out what our OpenGL implementation can do
+	GLExtensions::Init();
+}
+
 void
 App::Cleanup()
 {
@@ -197,9 +334,30 @@ App::Cleanup()
 	m_poMusicPlayer = NULL;
 	m_poExtra = NULL;
 
-	m_poEvents->Cleanup();
-	delete m_poEvents;
-	m_poEvents = NULL;
+	delete m_poFrameScheduler;
+	m_poFrameScheduler = NULL;
+	delete m_poWindowSkin;
+	m_poWindowSkin = NULL;
+	delete m_poGlyphCache;
+	m_poGlyphCache = NULL;
+	delete m_poSpriteBatch;
+	m_poSpriteBatch = NULL;
+
+	// All textures are gone, so their pixel buffers are back in the pool
+	PixelBufferPool::Cleanup();
+
+	// Likewise, their OpenGL textures are back in the pool
+	TexturePool::Cleanup();
+
+	// The decode threads are gone as well, so no one uses their contexts
+	SharedContext::Cleanup();
+
+	// The benchmarks run without events
+	if (m_poEvents != NULL) {
+		m_poEvents->Cleanup();
+		delete m_poEvents;
+		m_poEvents = NULL;
+	}
 
 	Mix_Quit();
 	TTF_Quit();
@@ -223,18 +381,44 @@ App::GetEvents()
 	return *m_poEvents;
 }
 
+SpriteBatch&
+App::GetSpriteBatch()
+{
+	assert(m_poSpriteBatch != NULL);
+	return *m_poSpriteBatch;
+}
+
+GlyphCache&
+App::GetGlyphCache()
+{
+	assert(m_poGlyphCache != NULL);
+	return *m_poGlyphCache;
+}
+
+WindowSkin&
+App::GetWindowSkin()
+{
+	assert(m_poWindowSkin != NULL);
+	return *m_poWindowSkin;
+}
+
 void
 App::Launch()
 {
 	assert(m_poCurrentApp != NULL);
 	m_poCurrentApp->Init();
-	m_poCurrentApp->Run();
+	m_poFrameScheduler->Run(*m_poCurrentApp);
 	m_poCurrentApp->Cleanup();
 }
 
 void
 App::Run()
 {
+	if (m_bBenchmark) {
+		Benchmark::Run();
+		return;
+	}
+
 	m_poCurrentApp = m_poClock;
 	Launch();
 	while (1) {
@@ -12,6 +12,10 @@ class Events;
 class MusicPlayer;
 class Extra;
 class IRunnable;
+class SpriteBatch;
+class GlyphCache;
+class WindowSkin;
+class FrameScheduler;
 
 typedef struct _TTF_Font TTF_Font;
 
@@ -34,9 +38,12 @@ public:
 	//! \brief Retrieve the screen width
 	int GetScreenWidth() const { return m_iWidth; }
 
-	//! \brief Retrieve the intended FPS count
+	//! \brief Retrieve the intended FPS count, which is also the update rate
 	int GetDesiredFPS() const { return m_iDesiredFPS; }
 
+	//! \brief Should statistics be reported?
+	bool IsVerbose() const { return m_bVerbose; }
+
 	//! \brief Retrieve the loaded font
 	TTF_Font* GetFont() { return m_pFont; }
 
@@ -46,6 +53,15 @@ public:
 	//! \brief Retrieve the events manager
 	Events& GetEvents();
 
+	//! \brief Retrieve the sprite batch everything is drawn with
+	SpriteBatch& GetSpriteBatch();
+
+	//! \brief Retrieve the glyph cache all text is drawn with
+	GlyphCache& GetGlyphCache();
+
+	//! \brief Retrieve the skin all windows are drawn with
+	WindowSkin& GetWindowSkin();
+
 	//! \brief Retrieve the root path to the application data
 	const std::string& GetDataPath() const { return m_sDataPath; }
 
@@ -56,6 +72,11 @@ protected:
 	//! \brief Launches the currently running application
 	void Launch();
 
+	/*! \brief Sets the video mode and initializes OpenGL
+	 *  \param iBitsPerPixel Color depth of the display
+	 */
+	void InitVideo(int iBitsPerPixel);
+
 private:
 	//! \brief Image library
 	ImageLibrary* m_poImageLibrary;
@@ -69,6 +90,15 @@ private:
 	//! \brief Events subsystem
 	Events* m_poEvents;
 
+	//! \brief Sprite batch
+	SpriteBatch* m_poSpriteBatch;
+
+	//! \brief Glyph cache for our font
+	GlyphCache* m_poGlyphCache;
+
+	//! \brief Window skin
+	WindowSkin* m_poWindowSkin;
+
 	//! \brief Our embedded photo viewer
 	PhotoViewer* m_poPhotoViewer;
 
@@ -90,6 +120,9 @@ private:
 	//! \brief Currently running application
 	IRunnable* m_poCurrentApp;
 
+	//! \brief Main loop driving the current application
+	FrameScheduler* m_poFrameScheduler;
+
 	//! \brief Screen height, in pixel-like units
 	int m_iHeight;
 
@@ -99,6 +132,30 @@ private:
 	//! \brief Desired FPS count
 	int m_iDesiredFPS;
 
+	//! \brief Number of image decode workers
+	int m_iNumDecodeWorkers;
+
+	//! \brief System memory budget for cached images, in MB
+	int m_iSystemCacheSize;
+
+	//! \brief Video memory budget for cached images, in MB
+	int m_iVideoCacheSize;
+
+	//! \brief Time that may be spent uploading images per frame, in ms
+	int m_iUploadBudget;
+
+	//! \brief Should the decode threads upload images themselves?
+	bool m_bSharedContexts;
+
+	//! \brief Are we reporting statistics?
+	bool m_bVerbose;
+
+	//! \brief Should we run the benchmarks instead of the applications?
+	bool m_bBenchmark;
+
+	//! \brief Should buffer swaps wait for the vertical retrace?
+	bool m_bVSync;
+
 };
 
 extern App g_oApp;
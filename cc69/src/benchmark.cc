@@ -0,0 +1,339 @@
+#include "benchmark.h"
+#include <GL/gl.h>
+#include <SDL/SDL.h>
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+#include <vector>
+#include "app.h"
+#include "cpu.h"
+#include "fireworks.h"
+#include "gpufireworks.h"
+#include "particlebudget.h"
+#include "particlestore.h"
+#include "pixelconverter.h"
+#include "random.h"
+#include "scaler.h"
+
+boost::posix_time::ptime
+Benchmark::Now()
+{
+	return boost::posix_time::microsec_clock::universal_time();
+}
+
+double
+Benchmark::SecondsSince(const boost::posix_time::ptime& oStart)
+{
+	return (Now() - oStart).total_microseconds() / 1000000.0;
+}
+
+void
+Benchmark::RunScaler()
+{
+	// Scale a 24 megapixel photo down to a 1024x768 screen
+	const int iWidth = 6000, iHeight = 4000;
+	int iFitWidth, iFitHeight;
+	Scaler::CalculateFit(iWidth, iHeight, 1024, 768, iFitWidth, iFitHeight);
+
+	for (int iBytesPerPixel = 3; iBytesPerPixel <= 4; iBytesPerPixel++) {
+		SDL_Surface* pSource = SDL_CreateRGBSurface(SDL_SWSURFACE, iWidth, iHeight, iBytesPerPixel * 8, 0xff, 0xff00, 0xff0000, (iBytesPerPixel == 4) ? 0xff000000 : 0);
+		SDL_Surface* pScalar = SDL_CreateRGBSurface(SDL_SWSURFACE, iFitWidth, iFitHeight, iBytesPerPixel * 8, 0xff, 0xff00, 0xff0000, (iBytesPerPixel == 4) ? 0xff000000 : 0);
+		SDL_Surface* pSIMD = SDL_CreateRGBSurface(SDL_SWSURFACE, iFitWidth, iFitHeight, iBytesPerPixel * 8, 0xff, 0xff00, 0xff0000, (iBytesPerPixel == 4) ? 0xff000000 : 0);
+		for (int y = 0; y < iHeight; y++) {
+			uint8_t* pRow = (uint8_t*)pSource->pixels + y * pSource->pitch;
+			for (int x = 0; x < iWidth * iBytesPerPixel; x++)
+				pRow[x] = Random::Get(0, 255);
+		}
+
+		boost::posix_time::ptime oStart = Now();
+		for (int n = 0; n < m_ciNumIterations; n++)
+			Scaler::Scale(pSource, pScalar, false);
+		double fScalar = SecondsSince(oStart);
+
+		oStart = Now();
+		for (int n = 0; n < m_ciNumIterations; n++)
+			Scaler::Scale(pSource, pSIMD, true);
+		double fSIMD = SecondsSince(oStart);
+
+		bool bIdentical = true;
+		for (int y = 0; y < iFitHeight; y++)
+			bIdentical &= memcmp((uint8_t*)pScalar->pixels + y * pScalar->pitch, (uint8_t*)pSIMD->pixels + y * pSIMD->pitch, iFitWidth * iBytesPerPixel) == 0;
+
+		double fMegaPixels = (double)iWidth * iHeight * m_ciNumIterations / 1000000.0;
+		std::cout << "Scaler, " << iBytesPerPixel * 8 << "-bit " << iWidth << "x" << iHeight << " -> " << iFitWidth << "x" << iFitHeight << ": " <<
+		 "scalar " << fMegaPixels / fScalar << " MP/s, " <<
+		 (CPU::HasSSE2() ? "SSE2 " : "SSE2 (unavailable) ") << fMegaPixels / fSIMD << " MP/s" <<
+		 (bIdentical ? "" : " - RESULTS DIFFER") << "\n";
+
+		SDL_FreeSurface(pSIMD);
+		SDL_FreeSurface(pScalar);
+		SDL_FreeSurface(pSource);
+	}
+}
+
+void
+Benchmark::RunPixelConverter()
+{
+	// Expand a 1024x768 photo, which is what every JPEG texture goes through
+	const int iNumPixels = 1024 * 768;
+	uint8_t* pSource = new uint8_t[iNumPixels * 3];
+	uint32_t* pScalar = new uint32_t[iNumPixels];
+	uint32_t* pSIMD = new uint32_t[iNumPixels];
+	for (int n = 0; n < iNumPixels * 3; n++)
+		pSource[n] = Random::Get(0, 255);
+
+	const int iNumIterations = m_ciNumIterations * 10;
+	boost::posix_time::ptime oStart = Now();
+	for (int n = 0; n < iNumIterations; n++)
+		PixelConverter::ExpandRGBToRGBAScalar(pSource, pScalar, iNumPixels);
+	double fScalar = SecondsSince(oStart);
+
+	double fSIMD = 0.0;
+	bool bIdentical = true;
+	if (CPU::HasSSSE3()) {
+		oStart = Now();
+		for (int n = 0; n < iNumIterations; n++)
+			PixelConverter::ExpandRGBToRGBASSSE3(pSource, pSIMD, iNumPixels);
+		fSIMD = SecondsSince(oStart);
+		bIdentical = memcmp(pScalar, pSIMD, iNumPixels * sizeof(uint32_t)) == 0;
+	}
+
+	// Throughput is expressed in source megabytes
+	double fMegaBytes = (double)iNumPixels * 3 * iNumIterations / (1024.0 * 1024.0);
+	std::cout << "PixelConverter, RGB24 -> RGBA32: scalar " << fMegaBytes / fScalar << " MB/s, ";
+	if (CPU::HasSSSE3())
+		std::cout << "SSSE3 " << fMegaBytes / fSIMD << " MB/s" << (bIdentical ? "" : " - RESULTS DIFFER") << "\n";
+	else
+		std::cout << "SSSE3 unavailable\n";
+
+	delete[] pSIMD;
+	delete[] pScalar;
+	delete[] pSource;
+}
+
+void
+Benchmark::RunParticleStore()
+{
+	const int aiNumParticles[] = { 1000, 10000, 100000 };
+	for (unsigned int i = 0; i < sizeof(aiNumParticles) / sizeof(aiNumParticles[0]); i++) {
+		int iNumParticles = aiNumParticles[i];
+
+		// Fill two identical stores; nothing dies during the benchmark
+		ParticleStore oScalar(iNumParticles), oSIMD(iNumParticles);
+		for (int n = 0; n < iNumParticles; n++) {
+			float afValue[6] = {
+				Random::Get(-500.0f, 500.0f), Random::Get(-500.0f, 500.0f),
+				Random::Get(-2.0f, 2.0f), Random::Get(-2.0f, 2.0f),
+				Random::Get(0.0f, 0.05f), Random::Get(0.1f, 1.0f)
+			};
+			ParticleStore* apStore[2] = { &oScalar, &oSIMD };
+			for (int s = 0; s < 2; s++) {
+				ParticleStore& oStore = *apStore[s];
+				int iIndex = oStore.Add();
+				oStore.GetX()[iIndex] = afValue[0];
+				oStore.GetY()[iIndex] = afValue[1];
+				oStore.GetSpeedX()[iIndex] = afValue[2];
+				oStore.GetSpeedY()[iIndex] = afValue[3];
+				oStore.GetGravity()[iIndex] = afValue[4];
+				oStore.GetDecay()[iIndex] = afValue[5];
+				oStore.GetLifetime()[iIndex] = 1000000.0f;
+			}
+		}
+
+		// Every particle is updated the same number of times, regardless of the count
+		const int iNumIterations = m_ciNumIterations * (10000000 / iNumParticles);
+		boost::posix_time::ptime oStart = Now();
+		for (int n = 0; n < iNumIterations; n++)
+			ParticleStore::IntegrateScalar(oScalar);
+		double fScalar = SecondsSince(oStart);
+
+		double fSIMD = 0.0;
+		bool bIdentical = true;
+		if (CPU::HasSSE()) {
+			oStart = Now();
+			for (int n = 0; n < iNumIterations; n++)
+				ParticleStore::IntegrateSSE(oSIMD);
+			fSIMD = SecondsSince(oStart);
+			bIdentical =
+			 memcmp(oScalar.GetX(), oSIMD.GetX(), iNumParticles * sizeof(float)) == 0 &&
+			 memcmp(oScalar.GetY(), oSIMD.GetY(), iNumParticles * sizeof(float)) == 0 &&
+			 memcmp(oScalar.GetLifetime(), oSIMD.GetLifetime(), iNumParticles * sizeof(float)) == 0;
+		}
+
+		double fNumUpdates = (double)iNumParticles * iNumIterations;
+		std::cout << "ParticleStore, " << iNumParticles << " particles: scalar " << fNumUpdates / (fScalar * 1000.0) << " particles/ms, ";
+		if (CPU::HasSSE())
+			std::cout << "SSE " << fNumUpdates / (fSIMD * 1000.0) << " particles/ms" << (bIdentical ? "" : " - RESULTS DIFFER") << "\n";
+		else
+			std::cout << "SSE unavailable\n";
+	}
+}
+
+void
+Benchmark::RunParticleHandles()
+{
+	// Fill a store, remembering every handle and what it refers to
+	const int iNumParticles = 10000;
+	ParticleStore oStore(iNumParticles);
+	std::vector<ParticleStore::THandle> oHandles(iNumParticles);
+	for (int n = 0; n < iNumParticles; n++) {
+		int iIndex = oStore.Add(&oHandles[n]);
+		oStore.GetX()[iIndex] = (float)n;
+	}
+
+	// Kill half of them in random order and reuse their slots
+	std::vector<bool> oAlive(iNumParticles, true);
+	for (int n = 0; n < iNumParticles / 2; n++) {
+		int iParticle = Random::Get(0, iNumParticles - 1);
+		int iIndex = oStore.Lookup(oHandles[iParticle]);
+		if (iIndex < 0)
+			continue;
+		oStore.Kill(iIndex);
+		oAlive[iParticle] = false;
+	}
+	while (!oStore.IsFull())
+		oStore.GetX()[oStore.Add()] = -1.0f;
+
+	// Every handle must either be stale or still refer to the same particle
+	bool bCorrect = true;
+	const int iNumIterations = m_ciNumIterations * 100;
+	boost::posix_time::ptime oStart = Now();
+	for (int i = 0; i < iNumIterations; i++)
+		for (int n = 0; n < iNumParticles; n++) {
+			int iIndex = oStore.Lookup(oHandles[n]);
+			if (oAlive[n])
+				bCorrect &= iIndex >= 0 && oStore.GetX()[iIndex] == (float)n;
+			else
+				bCorrect &= iIndex < 0;
+		}
+	double fLookup = SecondsSince(oStart);
+
+	std::cout << "ParticleStore, " << iNumParticles << " handles: " <<
+	 (double)iNumParticles * iNumIterations / (fLookup * 1000.0) << " lookups/ms" <<
+	 (bCorrect ? "" : " - STALE OR WRONG HANDLES") << "\n";
+}
+
+void
+Benchmark::RunParticleBudget()
+{
+	// Ten rockets share what two of them need, so the others must wait their turn
+	const int iNumRockets = 10;
+	const int iBudget = 2 * FireworkEmitter::m_ciNumParticles;
+	const int iNumFrames = 150 * m_ciNumIterations;
+	ParticleBudget oBudget(iBudget);
+	std::vector<Fireworks*> oRockets;
+	int iNumLaunches = 0;
+	for (int n = 0; n < iNumRockets; n++) {
+		oRockets.push_back(new Fireworks(&oBudget));
+		oRockets.back()->Initialize();
+		if (oRockets.back()->GetStore().GetNumParticles() > 0)
+			iNumLaunches++;
+	}
+
+	int iMaxParticles = 0;
+	bool bAccounted = true;
+	boost::posix_time::ptime oStart = Now();
+	for (int f = 0; f < iNumFrames; f++) {
+		int iNumParticles = 0;
+		for (int n = 0; n < iNumRockets; n++) {
+			ParticleStore& oStore = oRockets[n]->GetStore();
+			bool bLanded = oStore.GetNumParticles() == 0;
+			oRockets[n]->Evolve();
+			if (bLanded && oStore.GetNumParticles() > 0)
+				iNumLaunches++;
+			iNumParticles += oStore.GetNumParticles();
+		}
+		iMaxParticles = std::max(iMaxParticles, iNumParticles);
+		bAccounted &= iNumParticles + oBudget.GetAvailable() == iBudget;
+	}
+	double fTime = SecondsSince(oStart);
+
+	std::cout << "ParticleBudget, " << iNumRockets << " rockets sharing " << iBudget << " particles: " <<
+	 iNumLaunches << " launches, at most " << iMaxParticles << " particles live, " <<
+	 fTime * 1000.0 / iNumFrames << " ms/frame" <<
+	 ((iMaxParticles <= iBudget && bAccounted) ? "" : " - BUDGET EXCEEDED") << "\n";
+
+	for (int n = 0; n < iNumRockets; n++)
+		delete oRockets[n];
+}
+
+void
+Benchmark::RunFireworks()
+{
+	// Both implementations draw the particle image, which is application data
+	if (g_oApp.GetDataPath().empty()) {
+		std::cout << "Fireworks: skipped, the particle image requires -d\n";
+		return;
+	}
+
+	// The CPU simulation is always measured; it is what we fall back to
+	const bool bSupported = GPUFireworks::IsSupported();
+
+	// Every rocket lasts 150 frames; run a few of them
+	const int iNumFrames = 150 * m_ciNumIterations;
+	const int aiNumSystems[] = { 1, 10, 100 };
+	for (unsigned int i = 0; i < sizeof(aiNumSystems) / sizeof(aiNumSystems[0]); i++) {
+		int iNumSystems = aiNumSystems[i];
+
+		std::vector<Fireworks*> oCPU;
+		std::vector<GPUFireworks*> oGPU;
+		bool bGPU = bSupported;
+		for (int n = 0; n < iNumSystems; n++) {
+			oCPU.push_back(new Fireworks());
+			oCPU.back()->Initialize();
+			if (!bSupported)
+				continue;
+			oGPU.push_back(new GPUFireworks());
+			bGPU &= oGPU.back()->Initialize();
+		}
+
+		// Only time what the CPU spends; the GPU may still be busy afterwards
+		glFinish();
+		boost::posix_time::ptime oStart = Now();
+		for (int f = 0; f < iNumFrames; f++)
+			for (int n = 0; n < iNumSystems; n++) {
+				oCPU[n]->Evolve();
+				oCPU[n]->Render();
+			}
+		double fCPU = SecondsSince(oStart);
+		glFinish();
+
+		double fGPU = 0.0;
+		if (bGPU) {
+			oStart = Now();
+			for (int f = 0; f < iNumFrames; f++)
+				for (int n = 0; n < iNumSystems; n++) {
+					oGPU[n]->Evolve();
+					oGPU[n]->Render();
+				}
+			fGPU = SecondsSince(oStart);
+			glFinish();
+		}
+
+		std::cout << "Fireworks, " << iNumSystems << " rockets: CPU simulation " << fCPU * 1000.0 / iNumFrames << " ms/frame, ";
+		if (bGPU)
+			std::cout << "vertex shader " << fGPU * 1000.0 / iNumFrames << " ms/frame\n";
+		else if (!bSupported)
+			std::cout << "vertex shaders unavailable\n";
+		else
+			std::cout << "vertex shader failed to build\n";
+
+		for (unsigned int n = 0; n < oGPU.size(); n++)
+			delete oGPU[n];
+		for (int n = 0; n < iNumSystems; n++)
+			delete oCPU[n];
+	}
+}
+
+void
+Benchmark::Run()
+{
+	RunScaler();
+	RunPixelConverter();
+	RunParticleStore();
+	RunParticleHandles();
+	RunParticleBudget();
+	RunFireworks();
+}
+
+/* vim:set ts=2 sw=2: */
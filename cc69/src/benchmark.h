@@ -0,0 +1,47 @@
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+/*! \brief Microbenchmarks for our performance-critical code
+ *
+ *  These are run by passing -b; they compare the optimized code paths to
+ *  their plain counterparts so that we know what they buy us on the
+ *  target hardware.
+ */
+class Benchmark
+{
+public:
+	//! \brief Runs all benchmarks and reports the results
+	static void Run();
+
+protected:
+	//! \brief Benchmarks the image scaler
+	static void RunScaler();
+
+	//! \brief Benchmarks the pixel format conversion
+	static void RunPixelConverter();
+
+	//! \brief Benchmarks the particle integration
+	static void RunParticleStore();
+
+	//! \brief Benchmarks particle handle lookups and checks that stale handles are rejected
+	static void RunParticleHandles();
+
+	//! \brief Benchmarks rockets sharing a particle budget and checks that it is respected
+	static void RunParticleBudget();
+
+	//! \brief Benchmarks the CPU time per frame of both fireworks implementations
+	static void RunFireworks();
+
+	//! \brief Retrieve the current time
+	static boost::posix_time::ptime Now();
+
+	//! \brief Retrieve the number of seconds since a given moment
+	static double SecondsSince(const boost::posix_time::ptime& oStart);
+
+	//! \brief Number of times each benchmark is repeated
+	static const int m_ciNumIterations = 10;
+};
+
+#endif /* __BENCHMARK_H__ */
@@ -6,6 +6,7 @@
 #include "app.h"
 #include "image.h"
 #include "events.h"
+#include "spritebatch.h"
 
 Clock::Clock()
 	: m_poBackgroundImage(NULL), m_poImage(NULL), m_poTallImage(NULL), m_poTalk1Image(NULL), m_poTalk2Image(NULL), m_poTalk3Image(NULL), m_bTurbo(false)
@@ -31,12 +32,12 @@ Clock::Init()
 		exit(EXIT_FAILURE);
 	}
 	m_poImage = new Image(g_oApp.GetDataPath() + "/clock_icon.png");
-	if (!m_poImage->Load()) {
+	if (!m_poImage->Load(&m_oAtlas)) {
 		std::cerr << "fatal: cannot load clock icon image\n";
 		exit(EXIT_FAILURE);
 	}
 	m_poTallImage = new Image(g_oApp.GetDataPath() + "/clock_hand.png");
-	if (!m_poTallImage->Load()) {
+	if (!m_poTallImage->Load(&m_oAtlas)) {
 		std::cerr << "fatal: cannot load clock hand image\n";
 		exit(EXIT_FAILURE);
 	}
@@ -55,6 +56,13 @@ Clock::Init()
     std::cerr << "fatal: cannot load talk 3 image\n";
     exit(EXIT_FAILURE);
   }
+
+	// Start at 8:55:42 AM
+	m_oStartTime = boost::posix_time::microsec_clock::local_time().time_of_day();
+	m_oStartTime -= boost::posix_time::hours(8);
+	m_oStartTime -= boost::posix_time::minutes(55);
+	m_oStartTime -= boost::posix_time::seconds(42);
+	m_bLeaving = false;
 }
 
 void
@@ -73,6 +81,7 @@ Clock::Cleanup()
   m_poTalk1Image = NULL;
   m_poTalk2Image = NULL;
   m_poTalk3Image = NULL;
+	m_oAtlas.Unload();
 }
 
 void
@@ -89,23 +98,13 @@ Clock::HandleEvents()
 }
 
 void
-Clock::Render()
+Clock::Render(float /* fAlpha */)
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glLoadIdentity();
-
-	glPushMatrix();
-	glTranslatef(0.0f, 0.0f, -0.8f);
-	m_poBackgroundImage->RenderFullScreen();
-	glPopMatrix();
+	SpriteBatch& oBatch = g_oApp.GetSpriteBatch();
+	SpriteBatch::Blend oAlphaBlend(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glBlendColor(0.25f, 0.25f, 0.25f, 1.0f);
-
-  float fZ = -0.6f;
-  float fTexHeight = m_poImage->GetNormalizedHeight();
-  float fTexWidth  = m_poImage->GetNormalizedWidth();
+	m_poBackgroundImage->RenderFullScreen(-0.8f);
 
 	float fRadius = g_oApp.GetScreenWidth() * 0.25f;
 	float fAngle = 0.0f;
@@ -114,126 +113,103 @@ Clock::Render()
 		float fY = g_oApp.GetScreenHeight() / 2;
 		fX += fRadius * cos(fAngle);
 		fY += fRadius * sin(fAngle);
+		fX -= m_poImage->GetWidth() / 2.0f;
+		fY -= m_poImage->GetWidth() / 2.0f;
 
-		glPushMatrix();
-		glTranslatef(fX - m_poImage->GetWidth() / 2.0f, fY - m_poImage->GetWidth() / 2.0f, 0.0f);
-
-		glBindTexture(GL_TEXTURE_2D, m_poImage->GetTextureID());
-		glBegin(GL_QUADS);
-		glTexCoord2f(     0.0f,       0.0f); glVertex3f(0, 0, fZ);
-		glTexCoord2f(fTexWidth,       0.0f); glVertex3f(m_poImage->GetWidth(), 0, fZ);
-		glTexCoord2f(fTexWidth, fTexHeight); glVertex3f(m_poImage->GetWidth(), m_poImage->GetHeight(), fZ);
-		glTexCoord2f(     0.0f, fTexHeight); glVertex3f(0, m_poImage->GetHeight(), fZ);
-		glEnd();
-		glPopMatrix();
+		oBatch.AddRect(m_poImage->GetTextureID(), oAlphaBlend,
+		 fX, fY, fX + m_poImage->GetWidth(), fY + m_poImage->GetHeight(), -0.6f,
+		 m_poImage->GetNormalizedLeft(), m_poImage->GetNormalizedTop(),
+		 m_poImage->GetNormalizedLeft() + m_poImage->GetNormalizedWidth(),
+		 m_poImage->GetNormalizedTop() + m_poImage->GetNormalizedHeight());
 
 		fAngle += M_PI / 6;
 	}
 
-	glPushMatrix();
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glBlendColor(0.0f, 0.0f, 0.0f, 1.0f);
-	glTranslatef(0.0f, 0.0f, -0.4f);
-
   // Two seconds after starting show talk picture 1 for 2 seconds
 	if ((int)m_fMinute == 55 && m_fSecond >= 44.0f && m_fSecond < 46.0f)
-		m_poTalk1Image->RenderFullScreen();
+		m_poTalk1Image->RenderFullScreen(-0.4f, oAlphaBlend);
 
 	// When talk picture 1 is done, show talk picture 2 for 2 seconds
 	if ((int)m_fMinute == 55 && m_fSecond >= 46.0f && m_fSecond < 48.0f)
-		m_poTalk2Image->RenderFullScreen();
+		m_poTalk2Image->RenderFullScreen(-0.4f, oAlphaBlend);
 
-	// When talk picture 2 is done, let the clock go faster
-	if ((int)m_fMinute == 55 && m_fSecond > 48.0f)
-		m_bTurbo = true;
-
-	// When it's 9:02:10 stop with faster time and show talk picture 3
-	if ((int)m_fMinute == 2 && m_fSecond > 10.0f) {
-		m_bTurbo = false;
-		m_poTalk3Image->RenderFullScreen();
-	}
-	glPopMatrix();
+	// When it's 9:02:10 show talk picture 3
+	if ((int)m_fMinute == 2 && m_fSecond > 10.0f)
+		m_poTalk3Image->RenderFullScreen(-0.4f, oAlphaBlend);
 
 	// Draw handles	
-	glTranslatef(0, 0, -0.2f);
-	DrawHandle(m_fHour * 5.0f, 50.0f, fRadius);
-	glTranslatef(0, 0, 0.05f);
-	DrawHandle(m_fMinute, 30.0f, fRadius * 0.75f);
-	glTranslatef(0, 0, 0.05f);
+	DrawHandle(m_fHour * 5.0f, 50.0f, fRadius, -0.2f);
+	DrawHandle(m_fMinute, 30.0f, fRadius * 0.75f, -0.15f);
+	DrawHandle(m_fSecond, 20.0f, fRadius, -0.1f);
 
-	DrawHandle(m_fSecond, 20.0f, fRadius);
-
-	glDisable(GL_BLEND);
-	SDL_GL_SwapBuffers();
+	oBatch.Flush();
 }
 
 void
-Clock::DrawHandle(float fValue, float fThickness, float fRadius)
+Clock::DrawHandle(float fValue, float fThickness, float fRadius, float fDepth)
 {
 	fValue = fmod(fValue + 45.0f, 60.0f);
 	assert(fValue >= 0.0f && fValue <= 60.0f);
-	float fTexHeight = m_poTallImage->GetNormalizedHeight();
-	float fTexWidth  = m_poTallImage->GetNormalizedWidth();
-
-	glPushMatrix();
 
-	glTranslatef(
-	 g_oApp.GetScreenWidth() / 2.0f,
-	 g_oApp.GetScreenHeight() / 2.0f,
-	 0.0f
-	);
-	glRotatef(fValue / (60.0f / 360.0f), 0, 0, 1);
-	glBindTexture(GL_TEXTURE_2D, m_poTallImage->GetTextureID());
+	/*
+	 * The handle is a quad from the center outwards, rotated around the
+	 * center of the screen.
+	 */
+	float fAngle = fValue * (2.0f * M_PI / 60.0f);
+	float fCos = cos(fAngle);
+	float fSin = sin(fAngle);
+	float fCenterX = g_oApp.GetScreenWidth() / 2.0f;
+	float fCenterY = g_oApp.GetScreenHeight() / 2.0f;
 
 	float H = fThickness;
 	float W = fRadius;
-	glBegin(GL_QUADS);
-	glTexCoord2f(     0.0f,       0.0f); glVertex3f(0,  -H, 0);
-	glTexCoord2f(fTexWidth,       0.0f); glVertex3f(W, -H, 0);
-	glTexCoord2f(fTexWidth, fTexHeight); glVertex3f(W, H, 0);
-	glTexCoord2f(     0.0f, fTexHeight); glVertex3f(0,  H, 0);
-	glEnd();
-
-	glPopMatrix();
+	const float afX[4] = { 0, W, W, 0 };
+	const float afY[4] = { -H, -H, H, H };
+	float afRotatedX[4], afRotatedY[4];
+	for (int n = 0; n < 4; n++) {
+		afRotatedX[n] = fCenterX + afX[n] * fCos - afY[n] * fSin;
+		afRotatedY[n] = fCenterY + afX[n] * fSin + afY[n] * fCos;
+	}
+
+	g_oApp.GetSpriteBatch().AddQuad(m_poTallImage->GetTextureID(),
+	 SpriteBatch::Blend(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA),
+	 afRotatedX, afRotatedY, fDepth,
+	 m_poTallImage->GetNormalizedLeft(), m_poTallImage->GetNormalizedTop(),
+	 m_poTallImage->GetNormalizedLeft() + m_poTallImage->GetNormalizedWidth(),
+	 m_poTallImage->GetNormalizedTop() + m_poTallImage->GetNormalizedHeight());
 }
 
 void
-Clock::Run()
+Clock::Update(float /* fStep */)
 {
-	boost::posix_time::time_duration start_time(boost::posix_time::microsec_clock::local_time().time_of_day());
+	boost::posix_time::time_duration duration(boost::posix_time::microsec_clock::local_time().time_of_day());
+	duration = duration - m_oStartTime;
+
+	if (m_bTurbo)
+		m_oStartTime -= boost::posix_time::seconds(1);
+
+	m_fSecond = duration.seconds();
+	m_fSecond += duration.fractional_seconds() / 1000000.0f;
+	m_fMinute = duration.minutes();
+	m_fMinute += duration.seconds() / 60.0f;
+	m_fHour = duration.hours();
+	if (m_fHour >= 12.0f)
+		m_fHour -= 12.0f;
+	m_fHour += (m_fMinute / 60.0f);
+
+	// Stop at 9:02:12 AM
+	if (m_fHour >= 9 && m_fMinute >= 2 && m_fSecond >= 12)
+		m_bLeaving = true;
 
-	// Start at 8:55:42 AM
-	start_time -= boost::posix_time::hours(8);
-	start_time -= boost::posix_time::minutes(55);
-	start_time -= boost::posix_time::seconds(42);
+	HandleEvents();
 
-	m_bLeaving = false;
-	while(!m_bLeaving) {
-		boost::posix_time::ptime time = boost::posix_time::microsec_clock::local_time();
-		boost::posix_time::time_duration duration( time.time_of_day() );
-		duration = duration - start_time;
-
-		if (m_bTurbo)
-			start_time -= boost::posix_time::seconds(1);
-
-		m_fSecond = duration.seconds();
-		m_fSecond += duration.fractional_seconds() / 1000000.0f;
-		m_fMinute = duration.minutes();
-		m_fMinute += duration.seconds() / 60.0f;
-		m_fHour = duration.hours();
-		if (m_fHour >= 12.0f)
-			m_fHour -= 12.0f;
-		m_fHour += (m_fMinute / 60.0f);
-
-		// Stop at 9:02:12 AM
-		if (m_fHour >= 9 && m_fMinute >= 2 && m_fSecond >= 12)
-			m_bLeaving = true;
-
-		HandleEvents();
-		Render();
-		SDL_Delay(1000 / g_oApp.GetDesiredFPS());
-	}
+	// When talk picture 2 is done, let the clock go faster
+	if ((int)m_fMinute == 55 && m_fSecond > 48.0f)
+		m_bTurbo = true;
+
+	// When it's 9:02:10 stop with faster time
+	if ((int)m_fMinute == 2 && m_fSecond > 10.0f)
+		m_bTurbo = false;
 }
 
 /* vim:set ts=2 sw=2: */
@@ -1,7 +1,9 @@
 #ifndef __CLOCK_H__
 #define __CLOCK_H__
 
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include "runnable.h"
+#include "textureatlas.h"
 
 class Image;
 
@@ -13,13 +15,14 @@ public:
 
 	virtual void Init();
 	virtual void Cleanup();
-	virtual void Run();
+	virtual void Update(float fStep);
+	virtual void Render(float fAlpha);
+	virtual bool IsFinished() { return m_bLeaving; }
 
 protected:
 	void HandleEvents();
-	void Render();
 
-	void DrawHandle(float fValue, float fThickness, float fRadius);
+	void DrawHandle(float fValue, float fThickness, float fRadius, float fDepth);
 
 private:
 	bool m_bLeaving;
@@ -33,6 +36,12 @@ private:
 	Image* m_poTalk2Image;
 	Image* m_poTalk3Image;
 
+	//! \brief Atlas holding the icon and hand images
+	TextureAtlas m_oAtlas;
+
+	//! \brief Time of day at which the clock showed midnight
+	boost::posix_time::time_duration m_oStartTime;
+
 	float m_fHour;
 	float m_fMinute;
 	float m_fSecond;
@@ -0,0 +1,51 @@
+#include "cpu.h"
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+boost::once_flag CPU::m_oDetectOnce = BOOST_ONCE_INIT;
+bool CPU::m_bSSE = false;
+bool CPU::m_bSSE2 = false;
+bool CPU::m_bSSSE3 = false;
+
+void
+CPU::Detect()
+{
+	boost::call_once(&CPU::Query, m_oDetectOnce);
+}
+
+void
+CPU::Query()
+{
+#if defined(__i386__) || defined(__x86_64__)
+	unsigned int eax, ebx, ecx, edx;
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+		m_bSSE = (edx & bit_SSE) != 0;
+		m_bSSE2 = (edx & bit_SSE2) != 0;
+		m_bSSSE3 = (ecx & bit_SSSE3) != 0;
+	}
+#endif
+}
+
+bool
+CPU::HasSSE()
+{
+	Detect();
+	return m_bSSE;
+}
+
+bool
+CPU::HasSSE2()
+{
+	Detect();
+	return m_bSSE2;
+}
+
+bool
+CPU::HasSSSE3()
+{
+	Detect();
+	return m_bSSSE3;
+}
+
+/* vim:set ts=2 sw=2: */
@@ -0,0 +1,43 @@
+#ifndef __CPU_H__
+#define __CPU_H__
+
+#include <boost/thread/once.hpp>
+
+//! \brief Determines which instruction set extensions the CPU offers
+class CPU
+{
+public:
+	//! \brief Does the CPU support SSE?
+	static bool HasSSE();
+
+	//! \brief Does the CPU support SSE2?
+	static bool HasSSE2();
+
+	//! \brief Does the CPU support SSSE3?
+	static bool HasSSSE3();
+
+private:
+	/*! \brief Queries the CPU; this is only done once
+	 *
+	 *  Decode workers may be the first to ask, so the query is guarded by
+	 *  m_oDetectOnce rather than a plain flag.
+	 */
+	static void Detect();
+
+	//! \brief Performs the actual query; called through m_oDetectOnce
+	static void Query();
+
+	//! \brief Ensures the CPU is queried exactly once
+	static boost::once_flag m_oDetectOnce;
+
+	//! \brief SSE support
+	static bool m_bSSE;
+
+	//! \brief SSE2 support
+	static bool m_bSSE2;
+
+	//! \brief SSSE3 support
+	static bool m_bSSSE3;
+};
+
+#endif /* __CPU_H__ */
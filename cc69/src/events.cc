@@ -1,11 +1,15 @@
 #include "events.h"
 #include <SDL/SDL.h>
+#include <SDL/SDL_syswm.h>
 #include <assert.h>
+#include <poll.h>
+#include <algorithm>
+#include "animation.h"
 #include "app.h"
 #include "gateware.h"
 
 Events::Events()
-	: m_poGateware(NULL), m_iPreviousHandwheel(0)
+	: m_iPreviousHandwheel(0), m_poGateware(NULL), m_iDisplayFD(-1)
 {
 	Reset();
 }
@@ -36,6 +40,7 @@ Events::Cleanup()
 		m_poGateware->Cleanup();
 	delete m_poGateware;
 	m_poGateware = NULL;
+	m_iDisplayFD = -1;
 }
 
 void
@@ -145,4 +150,73 @@ Events::Process()
 	}
 }
 
+int
+Events::GetDisplayFD()
+{
+	if (m_iDisplayFD >= 0)
+		return m_iDisplayFD;
+
+	// This is only known once the video mode is set
+	SDL_SysWMinfo oInfo;
+	SDL_VERSION(&oInfo.version);
+	if (SDL_GetWMInfo(&oInfo) <= 0 || oInfo.subsystem != SDL_SYSWM_X11)
+		return -1;
+	m_iDisplayFD = ConnectionNumber(oInfo.info.x11.display);
+	return m_iDisplayFD;
+}
+
+bool
+Events::HasGatewareInput()
+{
+	if (m_poGateware == NULL)
+		return false;
+
+	/*
+	 * Only look for changes; Process() handles them as usual, so that the
+	 * state it keeps is not disturbed.
+	 */
+	bool bStart, bStop;
+	int iHandwheel;
+	if (!m_poGateware->GetButtonAndHandwheelStatus(bStart, bStop, iHandwheel))
+		return false;
+	return bStart != m_bPreviousStart || bStop != m_bPreviousStop || iHandwheel != m_iPreviousHandwheel;
+}
+
+bool
+Events::WaitFor(int iTimeout)
+{
+	double fDeadline = MonotonicClock::Now() + iTimeout / 1000.0;
+	while (true) {
+		// Let SDL read whatever X11 has for us and see if anything is pending
+		SDL_Event event;
+		SDL_PumpEvents();
+		if (SDL_PeepEvents(&event, 1, SDL_PEEKEVENT, SDL_ALLEVENTS) > 0)
+			return true;
+		if (HasGatewareInput())
+			return true;
+
+		int iRemaining = (int)((fDeadline - MonotonicClock::Now()) * 1000.0);
+		if (iRemaining <= 0)
+			return false;
+		if (m_poGateware != NULL)
+			iRemaining = std::min(iRemaining, (int)m_ciGatewarePollTime);
+
+		int iFD = GetDisplayFD();
+		if (iFD < 0) {
+			// Nothing to sleep on; just look every now and then
+			SDL_Delay(std::min(iRemaining, (int)m_ciFallbackPollTime));
+			continue;
+		}
+
+		struct pollfd oPoll;
+		oPoll.fd = iFD;
+		oPoll.events = POLLIN;
+		oPoll.revents = 0;
+		poll(&oPoll, 1, iRemaining);
+	}
+
+	/* NOTREACHED */
+	return false;
+}
+
 /* vim:set ts=2 sw=2: */
@@ -25,6 +25,16 @@ public:
 	//! \brief Process pending events, if any
 	void Process();
 
+	/*! \brief Waits for input
+	 *  \param iTimeout Maximum time to wait, in milliseconds
+	 *  \returns true if there is input to process, false on timeout
+	 *
+	 *  This sleeps on the X11 connection. As the gateware only reports its
+	 *  status when asked, it is queried every m_ciGatewarePollTime
+	 *  milliseconds meanwhile. Nothing is processed; call Process() for that.
+	 */
+	bool WaitFor(int iTimeout);
+
 	//! \brief Resets all pending events
 	void Reset();
 
@@ -79,6 +89,17 @@ public:
 	bool GetAndRemoveMouseEvent(Point& oPoint);
 
 private:
+	//! \brief Retrieve the X11 connection file descriptor, -1 if there is none
+	int GetDisplayFD();
+
+	//! \brief Did the gateware buttons or handwheel change since they were last processed?
+	bool HasGatewareInput();
+
+	//! \brief Time between gateware queries while waiting, in milliseconds
+	static const int m_ciGatewarePollTime = 50;
+
+	//! \brief Time between looking for events while waiting without an X11 connection, in milliseconds
+	static const int m_ciFallbackPollTime = 10;
 
 	//! \brief Has the 'left' event occured
 	bool m_bLeft;
@@ -113,6 +134,9 @@ private:
 	//! \brief Gateware interface
 	Gateware* m_poGateware;
 
+	//! \brief X11 connection file descriptor, -1 if not known yet
+	int m_iDisplayFD;
+
 	//! \brief Pending mouse events
 	std::list<Point> m_oMouseEvents;
 };
@@ -1,88 +1,60 @@
 #include "fireworks.h"
+#include "particlebudget.h"
 #include "random.h"
 #include "app.h"
 
-Fireworks::Fireworks()
-	: ParticleEngine<FireworkParticle>(100)
+Fireworks::Fireworks(ParticleBudget* pBudget)
+	: ParticleSystem<FireworkEmitter, BallisticIntegrator, FireworkFade, FireworkLifecycle>(FireworkEmitter::m_ciNumParticles, FireworkEmitter(), pBudget)
 {
 }
 
 void
-Fireworks::Initialize()
+FireworkEmitter::Emit(ParticleStore& oStore)
 {
-	ParticleEngine<FireworkParticle>::Initialize();
-	Reset();
-}
+	if (oStore.GetNumParticles() > 0)
+		return;
 
-void
-Fireworks::Reset()
-{
-	ParticleEngine<FireworkParticle>::Reset();
+	// Never launch half a rocket
+	ParticleBudget* pBudget = oStore.GetBudget();
+	if (pBudget != NULL && pBudget->GetAvailable() < m_ciNumParticles)
+		return;
 
 	float fW = g_oApp.GetScreenWidth() / 2.0f;
 	float fInitialX = Random::Get(-fW, fW);
-	float fInitialSpeed = (fW - fInitialX) / 100.0f;
-
-	for (int i = 0; i < 100; i++) {
-		FireworkParticle& oParticle = AddParticle();
-		oParticle.Initialize();
-
-		oParticle.SetPosition(fInitialX, 0.0f, 0.0f);
-		if (fInitialX >= 0.0f)
-			oParticle.SetSpeed(-2.5f, -5.0f, 0.0f);
-		else
-			oParticle.SetSpeed(2.5f, -5.0f, 0.0f);
-	}
-}
-
-void
-Fireworks::OnAllParticlesDead()
-{
-	Reset();
-}
-
-void
-FireworkParticle::Evolve()
-{
-	Particle::Evolve();
-
-	// When showing the explosion, slightly fade it out each frame
-	if (m_iState == 1)
-		SetAlpha(m_fA - 0.02f);
-
-	if (!IsDead())
-		return;
 
-	m_iState++;
-	switch(m_iState) {
-		case 1: { // explosion
-			SetGravity(0.04f);
-			float x = Random::Get(-2.0f, 2.0f);
-			float y = Random::Get(-2.0f, 2.0f);
-			SetSpeed( x, y, 0.0f);
-			SetSize(3.0f);
-			SetColor(
-				Random::Get(0.0f, 1.0f),
-				Random::Get(0.0f, 1.0f),
-				Random::Get(0.0f, 1.0f)
-			);
-			SetLife(10.0f, 0.2f);
+	for (int i = 0; i < m_ciNumParticles; i++) {
+		int n = oStore.Add();
+		if (n < 0)
 			break;
-		}
+		oStore.GetR()[n] = 1.0f;
+		oStore.GetG()[n] = 1.0f;
+		oStore.GetB()[n] = 1.0f;
+		oStore.GetA()[n] = 1.0f;
+		oStore.GetSize()[n] = 5.0f;
+		oStore.GetLifetime()[n] = 100.0f;
+		oStore.GetDecay()[n] = 1.0f;
+		oStore.GetGravity()[n] = 0.03f;
+		oStore.GetState()[n] = FireworkLifecycle::m_ciStateRocket;
+
+		oStore.GetX()[n] = fInitialX;
+		oStore.GetSpeedX()[n] = (fInitialX >= 0.0f) ? -2.5f : 2.5f;
+		oStore.GetSpeedY()[n] = -5.0f;
 	}
 }
 
 void
-FireworkParticle::Initialize()
+FireworkLifecycle::Explode(ParticleStore& oStore, int n)
 {
-//	SetPosition(0.0f, 0.0f, 0.0f);
-//	SetSpeed(2.5f, -5.0f, 0.0f);
-	SetColor(1.0f, 1.0f, 1.0f);
-	SetSize(5.0f);
-	SetAlpha(1.0f);
-	SetLife(100.0f, 1.0f);
-	SetGravity(0.03f);
-	m_iState = 0;
+	oStore.GetGravity()[n] = 0.04f;
+	oStore.GetSpeedX()[n] = Random::Get(-2.0f, 2.0f);
+	oStore.GetSpeedY()[n] = Random::Get(-2.0f, 2.0f);
+	oStore.GetSpeedZ()[n] = 0.0f;
+	oStore.GetSize()[n] = 3.0f;
+	oStore.GetR()[n] = Random::Get(0.0f, 1.0f);
+	oStore.GetG()[n] = Random::Get(0.0f, 1.0f);
+	oStore.GetB()[n] = Random::Get(0.0f, 1.0f);
+	oStore.GetLifetime()[n] = 10.0f;
+	oStore.GetDecay()[n] = 0.2f;
 }
 
 /* vim:set ts=2 sw=2: */
@@ -1,29 +1,48 @@
 #ifndef __FIREWORKS_H__
 #define __FIREWORKS_H__
 
-#include "particleengine.h"
-#include "particle.h"
+#include "particlepolicies.h"
+#include "particlesystem.h"
 
-class FireworkParticle : public Particle
-{
-public:
-	virtual void Initialize();
-	virtual void Evolve();
+/*! \brief Launches a new rocket once all particles are gone
+ *
+ *  If the store shares a budget, the launch is held off until the budget
+ *  can take a complete rocket.
+ */
+struct FireworkEmitter {
+	void Emit(ParticleStore& oStore);
+
+	//! \brief Number of particles making up a rocket
+	static const int m_ciNumParticles = 100;
+};
 
-private:
-	//! \brief State
-	int m_iState;
+//! \brief Explodes rockets once their lifetime runs out
+struct FireworkLifecycle {
+	bool OnDeath(ParticleStore& oStore, int n) {
+		if (++oStore.GetState()[n] != m_ciStateExplosion)
+			return false;
+		Explode(oStore, n);
+		return true;
+	}
+
+	//! \brief Turns a particle of the rocket into part of the explosion
+	static void Explode(ParticleStore& oStore, int n);
+
+	//! \brief Particle states
+	static const int m_ciStateRocket = 0;
+	static const int m_ciStateExplosion = 1;
 };
 
-class Fireworks : public ParticleEngine<FireworkParticle>
+//! \brief Explosions slightly fade out each frame
+typedef LinearAlphaFade<FireworkLifecycle::m_ciStateExplosion> FireworkFade;
+
+class Fireworks : public ParticleSystem<FireworkEmitter, BallisticIntegrator, FireworkFade, FireworkLifecycle>
 {
 public:
-	Fireworks();
-	void Initialize();
-
-protected:
-	void Reset();
-	void OnAllParticlesDead();
+	/*! \brief Constructs a new fireworks rocket
+	 *  \param pBudget Budget shared with other rockets, if any
+	 */
+	Fireworks(ParticleBudget* pBudget = NULL);
 };
 
 #endif /* __FIREWORKS_H__ */
@@ -0,0 +1,123 @@
+#include "framescheduler.h"
+#include <SDL/SDL.h>
+#include <sys/resource.h>
+#include <iostream>
+#include "animation.h"
+#include "app.h"
+#include "events.h"
+#include "imagelibrary.h"
+#include "runnable.h"
+
+FrameScheduler::FrameScheduler(int iUpdateRate, bool bVSync)
+	: m_iUpdateRate(iUpdateRate), m_bVSync(bVSync), m_iNumFrames(0), m_iNumUpdates(0),
+	  m_iNumDroppedFrames(0), m_iNumSkippedUpdates(0), m_iNumWakeups(0), m_fIdleTime(0.0)
+{
+}
+
+void
+FrameScheduler::Run(IRunnable& oRunnable)
+{
+	m_iNumFrames = 0;
+	m_iNumUpdates = 0;
+	m_iNumDroppedFrames = 0;
+	m_iNumSkippedUpdates = 0;
+	m_iNumWakeups = 0;
+	m_fIdleTime = 0.0;
+
+	// Step lengths are kept in seconds; one step is due right away
+	const float fStep = 1.0f / m_iUpdateRate;
+	float fAccumulated = fStep;
+	double fStart = MonotonicClock::Now();
+	double fStartProcessorTime = GetProcessorTime();
+	double fPrevious = fStart;
+	while (!oRunnable.IsFinished()) {
+		double fNow = MonotonicClock::Now();
+		fAccumulated += (float)(fNow - fPrevious);
+		fPrevious = fNow;
+		m_iNumWakeups++;
+
+		int iNumUpdates = 0;
+		while (fAccumulated >= fStep && !oRunnable.IsFinished()) {
+			if (iNumUpdates == m_ciMaxUpdatesPerFrame) {
+				// We can't keep up; forget about the remaining time
+				int iNumSkipped = (int)(fAccumulated / fStep);
+				m_iNumSkippedUpdates += iNumSkipped;
+				fAccumulated -= iNumSkipped * fStep;
+				break;
+			}
+			oRunnable.Update(fStep);
+			fAccumulated -= fStep;
+			iNumUpdates++;
+		}
+		m_iNumUpdates += iNumUpdates;
+		if (oRunnable.IsFinished())
+			break;
+
+		/*
+		 * Spend a bit of time uploading decoded images; this is done once per
+		 * iteration rather than per step, so catching up on steps doesn't
+		 * multiply the time spent.
+		 */
+		g_oApp.GetImageLibrary().GetUploadScheduler().Process();
+
+		// Only draw if there is anything new to show
+		bool bRendered = false;
+		if (oRunnable.IsDirty()) {
+			if (iNumUpdates > 1)
+				m_iNumDroppedFrames += iNumUpdates - 1;
+			oRunnable.Render(fAccumulated / fStep);
+			SDL_GL_SwapBuffers();
+			m_iNumFrames++;
+			bRendered = true;
+		}
+
+		if (!bRendered && oRunnable.IsIdle()) {
+			/*
+			 * Nothing will change until there is input, so there is no need to
+			 * step; a single step handles whatever input woke us up. The time
+			 * spent waiting is not caught up on.
+			 */
+			g_oApp.GetEvents().WaitFor(m_ciIdleTimeout);
+			fNow = MonotonicClock::Now();
+			m_fIdleTime += fNow - fPrevious;
+			fPrevious = fNow;
+			fAccumulated = fStep;
+			continue;
+		}
+
+		// Unless the buffer swap waited for the vertical retrace, sleep until the next step is due
+		if (!m_bVSync || !bRendered) {
+			float fRemaining = fStep - fAccumulated - (float)(MonotonicClock::Now() - fPrevious);
+			if (fRemaining > 0.0f)
+				SDL_Delay((unsigned int)(fRemaining * 1000.0f));
+		}
+	}
+
+	ReportStatistics(MonotonicClock::Now() - fStart, GetProcessorTime() - fStartProcessorTime);
+}
+
+double
+FrameScheduler::GetProcessorTime()
+{
+	struct rusage oUsage;
+	if (getrusage(RUSAGE_SELF, &oUsage) < 0)
+		return 0.0;
+	return oUsage.ru_utime.tv_sec + oUsage.ru_utime.tv_usec / 1000000.0 +
+	 oUsage.ru_stime.tv_sec + oUsage.ru_stime.tv_usec / 1000000.0;
+}
+
+void
+FrameScheduler::ReportStatistics(double fDuration, double fProcessorTime)
+{
+	if (!g_oApp.IsVerbose() || fDuration <= 0.0)
+		return;
+
+	std::cerr << "scheduler: " << m_iNumFrames << " frames in " << (int)(fDuration * 1000.0) << " ms (" <<
+	 m_iNumFrames / fDuration << " fps), " << m_iNumUpdates << " updates, " <<
+	 m_iNumDroppedFrames << " dropped frames, " << m_iNumSkippedUpdates << " skipped updates" <<
+	 (m_bVSync ? "" : ", no vsync") << "\n";
+	std::cerr << "scheduler: idle " << (int)(m_fIdleTime * 100.0 / fDuration) << "% of the time, " <<
+	 m_iNumWakeups / fDuration << " wakeups/s, " << (int)(fProcessorTime * 100.0 / fDuration) << "% cpu\n";
+}
+
+/* vim:set ts=2 sw=2: */
@@ -0,0 +1,80 @@
+#ifndef __FRAMESCHEDULER_H__
+#define __FRAMESCHEDULER_H__
+
+class IRunnable;
+
+/*! \brief Runs subapplications at a fixed update rate
+ *
+ *  The real time that passes is accumulated and handed out in steps of a
+ *  fixed length, so that the state advances at the same pace no matter how
+ *  long frames take. After the steps that are due, a single frame is
+ *  rendered. If the buffer swap waits for the vertical retrace, that paces
+ *  the loop; otherwise we sleep until the next step is due.
+ *
+ *  Frames are only rendered if the subapplication reports something has
+ *  changed. If it is idle altogether, stepping stops and we sleep until there
+ *  is input, or at most m_ciIdleTimeout milliseconds so that work done in
+ *  the background is noticed.
+ *
+ *  Steps that pass without a frame being rendered while there was something
+ *  to render are counted as dropped frames. If we fall behind by more than
+ *  m_ciMaxUpdatesPerFrame steps, the remaining time is skipped rather than
+ *  caught up on.
+ */
+class FrameScheduler
+{
+public:
+	/*! \brief Constructs the scheduler
+	 *  \param iUpdateRate Number of steps per second
+	 *  \param bVSync Does swapping the buffers wait for the vertical retrace?
+	 */
+	FrameScheduler(int iUpdateRate, bool bVSync);
+
+	/*! \brief Runs a subapplication until it is finished
+	 *  \param oRunnable Subapplication to run, which must be initialized
+	 */
+	void Run(IRunnable& oRunnable);
+
+protected:
+	/*! \brief Reports the statistics of the previous Run(), if verbose
+	 *  \param fDuration Time the run took, in seconds
+	 *  \param fProcessorTime Processor time used meanwhile, in seconds
+	 */
+	void ReportStatistics(double fDuration, double fProcessorTime);
+
+	//! \brief Retrieve the processor time used by the process, in seconds
+	static double GetProcessorTime();
+
+private:
+	//! \brief Number of steps per second
+	int m_iUpdateRate;
+
+	//! \brief Does swapping the buffers wait for the vertical retrace?
+	bool m_bVSync;
+
+	//! \brief Number of frames rendered
+	int m_iNumFrames;
+
+	//! \brief Number of steps taken
+	int m_iNumUpdates;
+
+	//! \brief Number of steps which were not followed by a frame
+	int m_iNumDroppedFrames;
+
+	//! \brief Number of steps skipped because we fell too far behind
+	int m_iNumSkippedUpdates;
+
+	//! \brief Number of times we woke up, be it from sleeping, waiting for input or swapping buffers
+	int m_iNumWakeups;
+
+	//! \brief Time spent waiting while idle, in seconds
+	double m_fIdleTime;
+
+	//! \brief Maximum number of steps taken between two frames
+	static const int m_ciMaxUpdatesPerFrame = 5;
+
+	//! \brief Maximum time to wait for input while idle, in milliseconds
+	static const int m_ciIdleTimeout = 250;
+};
+
+#endif /* __FRAMESCHEDULER_H__ */
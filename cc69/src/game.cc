@@ -8,13 +8,14 @@
 #include "image.h"
 #include "messagewindow.h"
 #include "random.h"
+#include "spritebatch.h"
 
 Game::Game()
 	: m_poBackgroundImage(NULL), m_aiGameField(NULL), m_aiBlocksPerRow(NULL),
 	  m_poScoreWindow(NULL), m_poNextBlockWindow(NULL), m_poStatusWindow(NULL)
 {
 	m_fX = 10.0f; m_fY = 10.0f;
-	m_iSpeed = 10; m_iSpeedCounter = 0;
+	m_bDirty = true;
 }
 
 Game::~Game()
@@ -89,16 +90,13 @@ Game::Init()
 
 	// Windows
 	m_poScoreWindow = new MessageWindow(m_fBlockWidth * 10.0f, m_fBlockHeight, 3);
-	m_poScoreWindow->Create();
 	m_poScoreWindow->SetPosition(m_fX + m_fBlockWidth * (m_ciNumCols + 1), m_fY);
 	m_poNextBlockWindow = new MessageWindow(m_fBlockWidth * 10.0f, m_fBlockHeight * 4.0f, 3);
-	m_poNextBlockWindow->Create();
 	m_poNextBlockWindow->SetPosition(m_fX + m_fBlockWidth * (m_ciNumCols + 1), m_fY + m_fBlockHeight * 1.5f);
 	m_poNextBlockWindow->SetTextPosition(-1, 0.5f * m_fBlockHeight);
 	m_poNextBlockWindow->Update("Next block");
 	m_poStatusWindow = new MessageWindow(m_fBlockWidth * 10.0f, m_fBlockHeight * 2.0f, 3);
 	m_poStatusWindow->SetPosition(m_fX + m_fBlockWidth * (m_ciNumCols + 1), m_fY + m_fBlockHeight * 6.0f);
-	m_poStatusWindow->Create();
 
 	/*
 	 * Initialize the game field. Our game field actually looks like this:
@@ -117,6 +115,7 @@ Game::Init()
 	 */ 
 	m_aiGameField = new Block*[(m_ciNumCols + 2) * (m_ciNumRows + 1)];
 	Restart();
+	m_bLeaving = false;
 }
 
 void
@@ -135,6 +134,7 @@ Game::Cleanup()
 	m_poScoreWindow = NULL;
 	m_poNextBlockWindow = NULL;
 	m_poStatusWindow = NULL;
+	m_oPlayfieldLayer.Unload();
 }
 
 void
@@ -157,11 +157,13 @@ Game::Restart()
 	m_aiBlocksPerRow = new int[m_ciNumRows];
 	for (int i = 0; i < m_ciNumRows; i++)
 		m_aiBlocksPerRow[i] = 0;
+	m_oPlayfieldLayer.Invalidate();
 
 	// We're playing a game
 	m_iShapeX = m_ciNumCols / 2;
 	m_bPlaying = true;
 	m_bPlayerInControl = true;
+	m_oDropTimer.Start(m_ciDropTime / 1000.0f);
 	m_uiScore = 0;
 	IncrementScore(0); // to force an update
 	m_poStatusWindow->Update("Playing - [STOP] to quit");
@@ -239,19 +241,14 @@ Game::HandleEvents()
 }
 
 void
-Game::Block::Render()
+Game::Block::Render(float fX, float fY, float fZ, const SpriteBatch::Blend& oBlend)
 {
 	float W = m_oGame.GetBlockWidth();
 	float H = m_oGame.GetBlockHeight();
-	float Z = 0;
-
-	glBindTexture(GL_TEXTURE_2D, m_oGame.GetBlockTexture().GetTextureID());
-	glBegin(GL_QUADS);
-	glTexCoord2f(m_fLeft,  m_fTop); glVertex3f( 0, 0, Z);
-	glTexCoord2f(m_fRight, m_fTop); glVertex3f( W, 0, Z);
-	glTexCoord2f(m_fRight, m_fBottom); glVertex3f( W, H, Z);
-	glTexCoord2f(m_fLeft,  m_fBottom); glVertex3f( 0, H, Z);
-	glEnd();
+
+	g_oApp.GetSpriteBatch().AddRect(m_oGame.GetBlockTexture().GetTextureID(), oBlend,
+	 fX, fY, fX + W, fY + H, fZ,
+	 m_fLeft, m_fTop, m_fRight, m_fBottom);
 }
 
 Game::Shape::Shape(Block* pBlock)
@@ -284,15 +281,15 @@ Game::Shape::Point::Point(const Point& oPoint, int iRotate)
 }
 
 void
-Game::Shape::Render(Block& oBlock, int iRotate)
+Game::Shape::Render(Block& oBlock, int iRotate, float fX, float fY, float fZ, const SpriteBatch::Blend& oBlend)
 {
 	for (TPointList::iterator it = m_oPoint.begin(); it != m_oPoint.end(); it++) {
 		Point oPoint(*it, iRotate);
 
-		glPushMatrix();
-		glTranslatef(oPoint.GetX() * oBlock.GetGame().GetBlockWidth(), oPoint.GetY() * oBlock.GetGame().GetBlockHeight(), 0);
-		oBlock.Render();
-		glPopMatrix();
+		oBlock.Render(
+		 fX + oPoint.GetX() * oBlock.GetGame().GetBlockWidth(),
+		 fY + oPoint.GetY() * oBlock.GetGame().GetBlockHeight(),
+		 fZ, oBlend);
 	}
 }
 
@@ -339,6 +336,7 @@ Game::IncrementBlocksPerRow(int iRow)
 	assert(iRow >= 0 && iRow < m_ciNumRows);
 	m_aiBlocksPerRow[iRow]++;
 	assert(m_aiBlocksPerRow[iRow] >= 0 && m_aiBlocksPerRow[iRow] <= m_ciNumCols);
+	m_oPlayfieldLayer.Invalidate();
 }
 
 void
@@ -351,13 +349,15 @@ Game::RenderCurrentShape()
 	 * The -1 is necessary because the first column is not drawn (it's only used
 	 * for collision checking
 	 */
-	glTranslatef((m_iShapeX - 1) * m_fBlockWidth, m_iShapeY * m_fBlockHeight, 0.0f);
-	oShape.Render(oBlock, m_iShapeRotation);
+	oShape.Render(oBlock, m_iShapeRotation,
+	 m_fX + (m_iShapeX - 1) * m_fBlockWidth, m_fY + m_iShapeY * m_fBlockHeight, 0.0f,
+	 SpriteBatch::Blend(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 }
 
 void
 Game::TryToMoveCurrentShape(int iX)
 {
+	m_bDirty = true;
 	Shape& oShape = m_oShape[m_iShapeIndex]; 
 
 	m_iShapeX += iX;
@@ -370,6 +370,7 @@ Game::TryToMoveCurrentShape(int iX)
 void
 Game::TryToRotateCurrentShape(int iDirection)
 {
+	m_bDirty = true;
 	Shape& oShape = m_oShape[m_iShapeIndex]; 
 	int iPreviousRotation = m_iShapeRotation;
 
@@ -410,7 +411,8 @@ Game::NewShape()
 	else
 		m_iShapeIndex = Random::Get(0, m_oShape.size() - 1);
 	m_iShapeRotation = 0;
-	m_iRemovingLines = 0;
+	m_oRemoveAnimation.Stop();
+	m_bDirty = true;
 	m_bPlayerInControl = true;
 	m_iNextShapeIndex = Random::Get(0, m_oShape.size() - 1);
 
@@ -449,22 +451,24 @@ Game::MarkCompletedLines()
 	if (iNumLines == 0)
 		return false;
 
+	// Flagged lines fade out, so they are no longer part of the playfield
+	m_oPlayfieldLayer.Invalidate();
+
 	IncrementScore(powf(2, iNumLines - 1) * 100);
 	m_bPlayerInControl = false;
-	m_iRemovingLines = 1;
+	m_oRemoveAnimation.Start(m_ciRemoveTime / 1000.0f);
 	return true;
 }
 
 bool
-Game::HandleCompletedLines()
+Game::HandleCompletedLines(float fStep)
 {
-	if (m_iRemovingLines <= 0)
+	if (!m_oRemoveAnimation.IsRunning())
 		return false;
 
-	if (m_iRemovingLines <= m_ciRemoveTime) {
-		m_iRemovingLines++;
+	m_oRemoveAnimation.Advance(fStep);
+	if (m_oRemoveAnimation.IsRunning())
 		return true;
-	}
 
 	// Now remove all completed lines
 	for (int iRow = m_ciNumRows - 1; iRow >= 0; /* nothing */) {
@@ -481,6 +485,7 @@ Game::HandleCompletedLines()
 	}
 
 	// All lines are gone; we're done removing them
+	m_oPlayfieldLayer.Invalidate();
 	NewShape();
 	return false;
 }
@@ -496,14 +501,14 @@ Game::IncrementScore(int iValue)
 }
 
 void
-Game::HandleLogic()
+Game::HandleLogic(float fStep)
 {
-	if (HandleCompletedLines())
+	if (HandleCompletedLines(fStep))
 		return;
 
-	if (!m_bPlaying || ++m_iSpeedCounter < m_iSpeed)
+	if (!m_bPlaying || m_oDropTimer.Advance(fStep) == 0)
 		return;
-	m_iSpeedCounter = 0;
+	m_bDirty = true;
 
 	int iPreviousY = m_iShapeY;
 	m_iShapeY++;
@@ -524,101 +529,92 @@ Game::GameOver()
 {
 	m_bPlaying = false;
 	m_bPlayerInControl = false;
+	m_bDirty = true;
 	g_oApp.GetEvents().SetLEDs(Events::m_ciLedOn, Events::m_ciLedOn);
 	m_poStatusWindow->Update("Game over - [START] to play again, [STOP] to quit");
 }
 
 void
-Game::Render()
+Game::RenderPlayfield()
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	glLoadIdentity();
+	SpriteBatch& oBatch = g_oApp.GetSpriteBatch();
+	SpriteBatch::Blend oAlphaBlend(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	// Start with the background
-	glPushMatrix();
-	glTranslatef(0.0f, 0.0f, -0.8f);
-	m_poBackgroundImage->RenderFullScreen();
-	glPopMatrix();
+	m_poBackgroundImage->RenderFullScreen(-0.8f);
 
 	// Corner off the playfield	
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
-	glBlendColor(1.0f, 1.0f, 1.0f, 0.5f);
-
-	glTranslatef(m_fX, m_fY, 0.0f);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glBegin(GL_QUADS);
-	glVertex3f(0.0f, 0.0f, -0.5f);
-	glVertex3f(m_ciNumCols * m_fBlockWidth, 0.0f, -0.5f);
-	glVertex3f(m_ciNumCols * m_fBlockWidth, m_ciNumRows * m_fBlockHeight, -0.5f);
-	glVertex3f(0, m_ciNumRows * m_fBlockHeight, -0.5f);
-	glEnd();
-
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glBlendColor(0.0f, 0.0f, 0.0f, 1.0f);
-
-	// Display all our blocks
+	oBatch.AddRect(0, SpriteBatch::Blend(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA, 0.5f),
+	 m_fX, m_fY, m_fX + m_ciNumCols * m_fBlockWidth, m_fY + m_ciNumRows * m_fBlockHeight, -0.5f,
+	 0.0f, 0.0f, 0.0f, 0.0f);
+
+	// Display all our blocks, except those being removed
 	for (int y = 0; y < m_ciNumRows; y++) {
-		glPushMatrix();
-		glTranslatef(0.0f, y * m_fBlockWidth, -0.4f);
-		if (m_aiBlocksPerRow[y] == -1) {
-			glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
-      glBlendColor(1.0f, 1.0f, 1.0f, 1.0f - ((float)m_iRemovingLines / (float)(m_ciRemoveTime + 1)));
-		}
+		if (m_aiBlocksPerRow[y] == -1)
+			continue;
 		for (int x = 0; x < m_ciNumCols; x++) {
 			Block* pBlock = BlockAt(x + 1, y);
 			if (pBlock != NULL)
-				pBlock->Render();
-			glTranslatef(m_fBlockWidth, 0.0f, 0.0f);
+				pBlock->Render(m_fX + x * m_fBlockWidth, m_fY + y * m_fBlockWidth, -0.4f, oAlphaBlend);
 		}
-		if (m_aiBlocksPerRow[y] == -1) {
-			// Reset blend for the remaining rows
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-			glBlendColor(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+void
+Game::Render(float fAlpha)
+{
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	m_bDirty = false;
+	SpriteBatch& oBatch = g_oApp.GetSpriteBatch();
+	SpriteBatch::Blend oAlphaBlend(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	// Render the playfield once and keep it until it changes
+	if (!m_oPlayfieldLayer.IsValid()) {
+		RenderPlayfield();
+		oBatch.Flush();
+		m_oPlayfieldLayer.Capture();
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+	m_oPlayfieldLayer.Render(-0.8f);
+
+	// Rows being removed fade out on top of it
+	SpriteBatch::Blend oRemoveBlend(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA,
+	 1.0f - m_oRemoveAnimation.GetProgress(fAlpha / g_oApp.GetDesiredFPS()));
+	for (int y = 0; y < m_ciNumRows; y++) {
+		if (m_aiBlocksPerRow[y] != -1)
+			continue;
+		for (int x = 0; x < m_ciNumCols; x++) {
+			Block* pBlock = BlockAt(x + 1, y);
+			if (pBlock != NULL)
+				pBlock->Render(m_fX + x * m_fBlockWidth, m_fY + y * m_fBlockWidth, -0.4f, oRemoveBlend);
 		}
-		glPopMatrix();
 	}
 
 	// Show the current block if we're not removing lines
-	if (!m_iRemovingLines)
+	if (!m_oRemoveAnimation.IsRunning())
 		RenderCurrentShape();
 
-	glLoadIdentity();
 	m_poScoreWindow->Render();
 	m_poStatusWindow->Render();
 	m_poNextBlockWindow->Render();
-	glEnable(GL_BLEND);
 
 	if (m_iNextShapeIndex >= 0) {
 		Block& oBlock = m_oBlock[m_iNextShapeIndex];
 		Shape& oShape = m_oShape[m_iNextShapeIndex];
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glBlendColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glLoadIdentity();
 		// Center the block within this window as much as we can
 		float fX = m_poNextBlockWindow->GetX() + m_poNextBlockWindow->GetWidth() / 2.0f;
 		float fY = m_poNextBlockWindow->GetY() + m_poNextBlockWindow->GetHeight() / 2.0f;
-		glTranslatef(fX, fY, 0.5f);
-		oShape.Render(oBlock, 0);
+		oShape.Render(oBlock, 0, fX, fY, 0.5f, oAlphaBlend);
 	}
 
-	glDisable(GL_BLEND);
-
-	// Render
-	SDL_GL_SwapBuffers();
+	oBatch.Flush();
 }
 
 void
-Game::Run()
+Game::Update(float fStep)
 {
-	m_bLeaving = false;
-	while(!m_bLeaving) {
-		HandleEvents();
-		HandleLogic();
-		Render();
-		SDL_Delay(1000 / g_oApp.GetDesiredFPS());
-	}
+	HandleEvents();
+	HandleLogic(fStep);
 }
 
 /* vim:set ts=2 sw=2: */
@@ -3,7 +3,10 @@
 
 #include <list>
 #include <vector>
+#include "animation.h"
 #include "runnable.h"
+#include "screenlayer.h"
+#include "spritebatch.h"
 #include "texture.h"
 
 class Image;
@@ -17,7 +20,11 @@ public:
 
 	virtual void Init();
 	virtual void Cleanup();
-	virtual void Run();
+	virtual void Update(float fStep);
+	virtual void Render(float fAlpha);
+	virtual bool IsFinished() { return m_bLeaving; }
+	virtual bool IsDirty() { return m_bDirty || m_oRemoveAnimation.IsRunning(); }
+	virtual bool IsIdle() { return !m_bPlaying && !m_oRemoveAnimation.IsRunning(); }
 
 	//! \brief Retrieve the block width
 	float GetBlockWidth() { return m_fBlockWidth; }
@@ -33,8 +40,14 @@ private:
 
 protected:
 	void HandleEvents();
-	void HandleLogic();
-	void Render();
+	void HandleLogic(float fStep);
+
+	/*! \brief Renders everything that only changes with the playfield
+	 *
+	 *  This is the background and all blocks in place, except those in rows
+	 *  being removed. The result is cached in m_oPlayfieldLayer.
+	 */
+	void RenderPlayfield();
 
 	void NewShape();
 	void RenderCurrentShape();
@@ -44,7 +57,7 @@ protected:
 	void DropCurrentShape();
 	void GameOver();
 	bool MarkCompletedLines();
-	bool HandleCompletedLines();
+	bool HandleCompletedLines(float fStep);
 	void Restart();
 
 	bool CheckCurrentShapeColission(int iDirection);
@@ -75,20 +88,29 @@ private:
 	//! \brief Texture containg the block images
 	Texture m_oBlockTexture;
 
+	/*! \brief Cached rendering of the playfield
+	 *
+	 *  This must be invalidated whenever a block is placed or removed.
+	 */
+	ScreenLayer m_oPlayfieldLayer;
+
 	//! \brief Background image
 	Image* m_poBackgroundImage;
 
 	//! \brief Are we still here?
 	bool m_bLeaving;
 
+	//! \brief Has anything moved since the last Render()?
+	bool m_bDirty;
+
 	//! \brief Score
 	unsigned int m_uiScore;
 
-	//! \brief Game speed
-	int m_iSpeed;
+	//! \brief Drops the current shape a row whenever it fires
+	Timer m_oDropTimer;
 
-	//! \brief Current speed counter
-	int m_iSpeedCounter;
+	//! \brief Time it takes the current shape to drop a row, in milliseconds
+	static const int m_ciDropTime = 166;
 
 	//! \brief Number of blocks
 	static const int m_ciNumBlocks = 7;
@@ -104,7 +126,13 @@ private:
 		{
 		}
 
-		void Render();
+		/*! \brief Submits the block to the sprite batch
+		 *  \param fX Left position of the block
+		 *  \param fY Top position of the block
+		 *  \param fZ Depth of the block
+		 *  \param oBlend Blending to use
+		 */
+		void Render(float fX, float fY, float fZ, const SpriteBatch::Blend& oBlend);
 		Game& GetGame() { return m_oGame; }
 
 		//! \brief Copy constructor, used by std::vector::push_back()
@@ -142,8 +170,11 @@ private:
 			m_oPoint.push_back(Point(iX, iY));
 		}
 
-		/*! \brief Renders the shape using given blocks */
-		void Render(Block& oBlock, int iRotate);
+		/*! \brief Renders the shape using given blocks
+		 *
+		 *  The shape is positioned relative to (fX, fY) at depth fZ.
+		 */
+		void Render(Block& oBlock, int iRotate, float fX, float fY, float fZ, const SpriteBatch::Blend& oBlend);
 
 		//! \brief Directions
 		static const int m_ciDirEast = 0;
@@ -225,11 +256,11 @@ private:
 	//! \brief Number of blocks per row
 	int* m_aiBlocksPerRow;
 
-	//! \brief Lines-removing animation counter
-	int m_iRemovingLines;
+	//! \brief Lines-removing animation
+	Animation m_oRemoveAnimation;
 
-	//! \brief Amount of frames to remove the row
-	static const int m_ciRemoveTime = 20; /* 0.3 sec at 60 fps */
+	//! \brief Time it takes to remove the rows, in milliseconds
+	static const int m_ciRemoveTime = 333;
 
 	//! \brief Score window
 	MessageWindow* m_poScoreWindow;
@@ -0,0 +1,112 @@
+#include "glextensions.h"
+#include <SDL/SDL.h>
+#include <iostream>
+#include "app.h"
+
+std::string GLExtensions::m_sExtensions;
+bool GLExtensions::m_bNonPowerOfTwoTextures = false;
+bool GLExtensions::m_bVertexBufferObjects = false;
+bool GLExtensions::m_bPixelBufferObjects = false;
+PFNGLGENBUFFERSARBPROC GLExtensions::m_pGenBuffers = NULL;
+PFNGLDELETEBUFFERSARBPROC GLExtensions::m_pDeleteBuffers = NULL;
+PFNGLBINDBUFFERARBPROC GLExtensions::m_pBindBuffer = NULL;
+PFNGLBUFFERDATAARBPROC GLExtensions::m_pBufferData = NULL;
+PFNGLMAPBUFFERARBPROC GLExtensions::m_pMapBuffer = NULL;
+PFNGLUNMAPBUFFERARBPROC GLExtensions::m_pUnmapBuffer = NULL;
+bool GLExtensions::m_bSync = false;
+PFNGLFENCESYNCPROC GLExtensions::m_pFenceSync = NULL;
+PFNGLCLIENTWAITSYNCPROC GLExtensions::m_pClientWaitSync = NULL;
+PFNGLWAITSYNCPROC GLExtensions::m_pWaitSync = NULL;
+PFNGLDELETESYNCPROC GLExtensions::m_pDeleteSync = NULL;
+bool GLExtensions::m_bVertexShaders = false;
+PFNGLCREATESHADEROBJECTARBPROC GLExtensions::m_pCreateShaderObject = NULL;
+PFNGLSHADERSOURCEARBPROC GLExtensions::m_pShaderSource = NULL;
+PFNGLCOMPILESHADERARBPROC GLExtensions::m_pCompileShader = NULL;
+PFNGLCREATEPROGRAMOBJECTARBPROC GLExtensions::m_pCreateProgramObject = NULL;
+PFNGLATTACHOBJECTARBPROC GLExtensions::m_pAttachObject = NULL;
+PFNGLLINKPROGRAMARBPROC GLExtensions::m_pLinkProgram = NULL;
+PFNGLUSEPROGRAMOBJECTARBPROC GLExtensions::m_pUseProgramObject = NULL;
+PFNGLDELETEOBJECTARBPROC GLExtensions::m_pDeleteObject = NULL;
+PFNGLGETOBJECTPARAMETERIVARBPROC GLExtensions::m_pGetObjectParameteriv = NULL;
+PFNGLGETINFOLOGARBPROC GLExtensions::m_pGetInfoLog = NULL;
+PFNGLGETUNIFORMLOCATIONARBPROC GLExtensions::m_pGetUniformLocation = NULL;
+PFNGLUNIFORM1FARBPROC GLExtensions::m_pUniform1f = NULL;
+PFNGLUNIFORM2FARBPROC GLExtensions::m_pUniform2f = NULL;
+
+void
+GLExtensions::Init()
+{
+	const char* pExtensions = (const char*)glGetString(GL_EXTENSIONS);
+	m_sExtensions = " " + std::string((pExtensions != NULL) ? pExtensions : "") + " ";
+
+	m_bNonPowerOfTwoTextures = IsSupported("GL_ARB_texture_non_power_of_two");
+	m_bVertexBufferObjects = IsSupported("GL_ARB_vertex_buffer_object") && InitBufferObjects();
+	m_bPixelBufferObjects = m_bVertexBufferObjects && IsSupported("GL_ARB_pixel_buffer_object");
+	m_bSync = IsSupported("GL_ARB_sync") && InitSync();
+	m_bVertexShaders =
+	 IsSupported("GL_ARB_shader_objects") && IsSupported("GL_ARB_vertex_shader") &&
+	 IsSupported("GL_ARB_shading_language_100") && InitShaders();
+
+	if (g_oApp.IsVerbose()) {
+		std::cerr << "OpenGL: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << "\n";
+		std::cerr << "OpenGL: non-power-of-two textures " << (m_bNonPowerOfTwoTextures ? "supported" : "unsupported") << "\n";
+		std::cerr << "OpenGL: vertex buffer objects " << (m_bVertexBufferObjects ? "supported" : "unsupported") << "\n";
+		std::cerr << "OpenGL: pixel buffer objects " << (m_bPixelBufferObjects ? "supported" : "unsupported") << "\n";
+		std::cerr << "OpenGL: sync objects " << (m_bSync ? "supported" : "unsupported") << "\n";
+		std::cerr << "OpenGL: vertex shaders " << (m_bVertexShaders ? "supported" : "unsupported") << "\n";
+	}
+}
+
+bool
+GLExtensions::IsSupported(const std::string& sName)
+{
+	// Pad the name so that we won't match prefixes of longer names
+	return m_sExtensions.find(" " + sName + " ") != std::string::npos;
+}
+
+bool
+GLExtensions::InitBufferObjects()
+{
+	m_pGenBuffers = (PFNGLGENBUFFERSARBPROC)SDL_GL_GetProcAddress("glGenBuffersARB");
+	m_pDeleteBuffers = (PFNGLDELETEBUFFERSARBPROC)SDL_GL_GetProcAddress("glDeleteBuffersARB");
+	m_pBindBuffer = (PFNGLBINDBUFFERARBPROC)SDL_GL_GetProcAddress("glBindBufferARB");
+	m_pBufferData = (PFNGLBUFFERDATAARBPROC)SDL_GL_GetProcAddress("glBufferDataARB");
+	m_pMapBuffer = (PFNGLMAPBUFFERARBPROC)SDL_GL_GetProcAddress("glMapBufferARB");
+	m_pUnmapBuffer = (PFNGLUNMAPBUFFERARBPROC)SDL_GL_GetProcAddress("glUnmapBufferARB");
+	return m_pGenBuffers != NULL && m_pDeleteBuffers != NULL && m_pBindBuffer != NULL &&
+	       m_pBufferData != NULL && m_pMapBuffer != NULL && m_pUnmapBuffer != NULL;
+}
+
+bool
+GLExtensions::InitSync()
+{
+	m_pFenceSync = (PFNGLFENCESYNCPROC)SDL_GL_GetProcAddress("glFenceSync");
+	m_pClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)SDL_GL_GetProcAddress("glClientWaitSync");
+	m_pWaitSync = (PFNGLWAITSYNCPROC)SDL_GL_GetProcAddress("glWaitSync");
+	m_pDeleteSync = (PFNGLDELETESYNCPROC)SDL_GL_GetProcAddress("glDeleteSync");
+	return m_pFenceSync != NULL && m_pClientWaitSync != NULL && m_pWaitSync != NULL && m_pDeleteSync != NULL;
+}
+
+bool
+GLExtensions::InitShaders()
+{
+	m_pCreateShaderObject = (PFNGLCREATESHADEROBJECTARBPROC)SDL_GL_GetProcAddress("glCreateShaderObjectARB");
+	m_pShaderSource = (PFNGLSHADERSOURCEARBPROC)SDL_GL_GetProcAddress("glShaderSourceARB");
+	m_pCompileShader = (PFNGLCOMPILESHADERARBPROC)SDL_GL_GetProcAddress("glCompileShaderARB");
+	m_pCreateProgramObject = (PFNGLCREATEPROGRAMOBJECTARBPROC)SDL_GL_GetProcAddress("glCreateProgramObjectARB");
+	m_pAttachObject = (PFNGLATTACHOBJECTARBPROC)SDL_GL_GetProcAddress("glAttachObjectARB");
+	m_pLinkProgram = (PFNGLLINKPROGRAMARBPROC)SDL_GL_GetProcAddress("glLinkProgramARB");
+	m_pUseProgramObject = (PFNGLUSEPROGRAMOBJECTARBPROC)SDL_GL_GetProcAddress("glUseProgramObjectARB");
+	m_pDeleteObject = (PFNGLDELETEOBJECTARBPROC)SDL_GL_GetProcAddress("glDeleteObjectARB");
+	m_pGetObjectParameteriv = (PFNGLGETOBJECTPARAMETERIVARBPROC)SDL_GL_GetProcAddress("glGetObjectParameterivARB");
+	m_pGetInfoLog = (PFNGLGETINFOLOGARBPROC)SDL_GL_GetProcAddress("glGetInfoLogARB");
+	m_pGetUniformLocation = (PFNGLGETUNIFORMLOCATIONARBPROC)SDL_GL_GetProcAddress("glGetUniformLocationARB");
+	m_pUniform1f = (PFNGLUNIFORM1FARBPROC)SDL_GL_GetProcAddress("glUniform1fARB");
+	m_pUniform2f = (PFNGLUNIFORM2FARBPROC)SDL_GL_GetProcAddress("glUniform2fARB");
+	return m_pCreateShaderObject != NULL && m_pShaderSource != NULL && m_pCompileShader != NULL &&
+	       m_pCreateProgramObject != NULL && m_pAttachObject != NULL && m_pLinkProgram != NULL &&
+	       m_pUseProgramObject != NULL && m_pDeleteObject != NULL && m_pGetObjectParameteriv != NULL &&
+	       m_pGetInfoLog != NULL && m_pGetUniformLocation != NULL && m_pUniform1f != NULL && m_pUniform2f != NULL;
+}
+
+/* vim:set ts=2 sw=2: */
@@ -0,0 +1,142 @@
+#ifndef __GLEXTENSIONS_H__
+#define __GLEXTENSIONS_H__
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <string>
+
+/*! \brief Keeps track of the OpenGL extensions available
+ *
+ *  Init() must be called once the OpenGL context has been created.
+ */
+class GLExtensions
+{
+public:
+	//! \brief Queries the OpenGL implementation
+	static void Init();
+
+	/*! \brief Checks whether an extension is supported
+	 *  \param sName Extension name, i.e. GL_ARB_texture_non_power_of_two
+	 *  \returns true if the extension is supported
+	 */
+	static bool IsSupported(const std::string& sName);
+
+	//! \brief Are textures allowed to have non-power-of-two sizes?
+	static bool HasNonPowerOfTwoTextures() { return m_bNonPowerOfTwoTextures; }
+
+	/*! \brief Are vertex buffer objects available?
+	 *
+	 *  The buffer object functions below may only be used if this holds.
+	 */
+	static bool HasVertexBufferObjects() { return m_bVertexBufferObjects; }
+
+	/*! \brief Are pixel buffer objects available?
+	 *
+	 *  This implies HasVertexBufferObjects().
+	 */
+	static bool HasPixelBufferObjects() { return m_bPixelBufferObjects; }
+
+	static void GenBuffers(GLsizei n, GLuint* pBuffers) { m_pGenBuffers(n, pBuffers); }
+	static void DeleteBuffers(GLsizei n, const GLuint* pBuffers) { m_pDeleteBuffers(n, pBuffers); }
+	static void BindBuffer(GLenum eTarget, GLuint iBuffer) { m_pBindBuffer(eTarget, iBuffer); }
+	static void BufferData(GLenum eTarget, GLsizeiptrARB iSize, const GLvoid* pData, GLenum eUsage) { m_pBufferData(eTarget, iSize, pData, eUsage); }
+	static GLvoid* MapBuffer(GLenum eTarget, GLenum eAccess) { return m_pMapBuffer(eTarget, eAccess); }
+	static GLboolean UnmapBuffer(GLenum eTarget) { return m_pUnmapBuffer(eTarget); }
+
+	/*! \brief Are sync objects available?
+	 *
+	 *  The sync object functions below may only be used if this holds.
+	 */
+	static bool HasSync() { return m_bSync; }
+
+	static GLsync FenceSync(GLenum eCondition, GLbitfield iFlags) { return m_pFenceSync(eCondition, iFlags); }
+	static GLenum ClientWaitSync(GLsync pSync, GLbitfield iFlags, GLuint64 iTimeout) { return m_pClientWaitSync(pSync, iFlags, iTimeout); }
+	static void WaitSync(GLsync pSync, GLbitfield iFlags, GLuint64 iTimeout) { m_pWaitSync(pSync, iFlags, iTimeout); }
+	static void DeleteSync(GLsync pSync) { m_pDeleteSync(pSync); }
+
+	/*! \brief Are GLSL vertex shaders available?
+	 *
+	 *  The shader functions below may only be used if this holds.
+	 */
+	static bool HasVertexShaders() { return m_bVertexShaders; }
+
+	static GLhandleARB CreateShaderObject(GLenum eType) { return m_pCreateShaderObject(eType); }
+	static void ShaderSource(GLhandleARB hShader, GLsizei iCount, const GLcharARB** pString, const GLint* pLength) { m_pShaderSource(hShader, iCount, pString, pLength); }
+	static void CompileShader(GLhandleARB hShader) { m_pCompileShader(hShader); }
+	static GLhandleARB CreateProgramObject() { return m_pCreateProgramObject(); }
+	static void AttachObject(GLhandleARB hProgram, GLhandleARB hShader) { m_pAttachObject(hProgram, hShader); }
+	static void LinkProgram(GLhandleARB hProgram) { m_pLinkProgram(hProgram); }
+	static void UseProgramObject(GLhandleARB hProgram) { m_pUseProgramObject(hProgram); }
+	static void DeleteObject(GLhandleARB hObject) { m_pDeleteObject(hObject); }
+	static void GetObjectParameteriv(GLhandleARB hObject, GLenum eName, GLint* pValue) { m_pGetObjectParameteriv(hObject, eName, pValue); }
+	static void GetInfoLog(GLhandleARB hObject, GLsizei iMaxLength, GLsizei* pLength, GLcharARB* pInfoLog) { m_pGetInfoLog(hObject, iMaxLength, pLength, pInfoLog); }
+	static GLint GetUniformLocation(GLhandleARB hProgram, const GLcharARB* pName) { return m_pGetUniformLocation(hProgram, pName); }
+	static void Uniform1f(GLint iLocation, GLfloat fValue) { m_pUniform1f(iLocation, fValue); }
+	static void Uniform2f(GLint iLocation, GLfloat fValue0, GLfloat fValue1) { m_pUniform2f(iLocation, fValue0, fValue1); }
+
+protected:
+	/*! \brief Looks up the buffer object entry points
+	 *  \returns true if all of them were found
+	 */
+	static bool InitBufferObjects();
+
+	/*! \brief Looks up the sync object entry points
+	 *  \returns true if all of them were found
+	 */
+	static bool InitSync();
+
+	/*! \brief Looks up the shader entry points
+	 *  \returns true if all of them were found
+	 */
+	static bool InitShaders();
+
+private:
+	//! \brief Extension string, padded with spaces at both ends
+	static std::string m_sExtensions;
+
+	//! \brief Non-power-of-two texture support
+	static bool m_bNonPowerOfTwoTextures;
+
+	//! \brief Vertex buffer object support
+	static bool m_bVertexBufferObjects;
+
+	//! \brief Pixel buffer object support
+	static bool m_bPixelBufferObjects;
+
+	//! \brief Buffer object entry points, as obtained from the implementation
+	static PFNGLGENBUFFERSARBPROC m_pGenBuffers;
+	static PFNGLDELETEBUFFERSARBPROC m_pDeleteBuffers;
+	static PFNGLBINDBUFFERARBPROC m_pBindBuffer;
+	static PFNGLBUFFERDATAARBPROC m_pBufferData;
+	static PFNGLMAPBUFFERARBPROC m_pMapBuffer;
+	static PFNGLUNMAPBUFFERARBPROC m_pUnmapBuffer;
+
+	//! \brief Sync object support
+	static bool m_bSync;
+
+	//! \brief Sync object entry points, as obtained from the implementation
+	static PFNGLFENCESYNCPROC m_pFenceSync;
+	static PFNGLCLIENTWAITSYNCPROC m_pClientWaitSync;
+	static PFNGLWAITSYNCPROC m_pWaitSync;
+	static PFNGLDELETESYNCPROC m_pDeleteSync;
+
+	//! \brief Vertex shader support
+	static bool m_bVertexShaders;
+
+	//! \brief Shader entry points, as obtained from the implementation
+	static PFNGLCREATESHADEROBJECTARBPROC m_pCreateShaderObject;
+	static PFNGLSHADERSOURCEARBPROC m_pShaderSource;
+	static PFNGLCOMPILESHADERARBPROC m_pCompileShader;
+	static PFNGLCREATEPROGRAMOBJECTARBPROC m_pCreateProgramObject;
+	static PFNGLATTACHOBJECTARBPROC m_pAttachObject;
+	static PFNGLLINKPROGRAMARBPROC m_pLinkProgram;
+	static PFNGLUSEPROGRAMOBJECTARBPROC m_pUseProgramObject;
+	static PFNGLDELETEOBJECTARBPROC m_pDeleteObject;
+	static PFNGLGETOBJECTPARAMETERIVARBPROC m_pGetObjectParameteriv;
+	static PFNGLGETINFOLOGARBPROC m_pGetInfoLog;
+	static PFNGLGETUNIFORMLOCATIONARBPROC m_pGetUniformLocation;
+	static PFNGLUNIFORM1FARBPROC m_pUniform1f;
+	static PFNGLUNIFORM2FARBPROC m_pUniform2f;
+};
+
+#endif /* __GLEXTENSIONS_H__ */
@@ -0,0 +1,166 @@
+#include "glyphcache.h"
+#include <SDL/SDL.h>
+#include <SDL/SDL_ttf.h>
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include "app.h"
+#include "spritebatch.h"
+
+GlyphCache::GlyphCache(TTF_Font* pFont)
+	: m_pFont(pFont), m_iLineHeight(0)
+{
+	memset(m_aGlyph, 0, sizeof(m_aGlyph));
+}
+
+bool
+GlyphCache::Create()
+{
+	m_iLineHeight = TTF_FontHeight(m_pFont);
+
+	// Glyphs are rendered in white so that Draw() can color them
+	SDL_Color oWhite;
+	oWhite.r = 255; oWhite.g = 255; oWhite.b = 255;
+	SDL_Surface* apGlyph[m_ciLastGlyph - m_ciFirstGlyph + 1];
+	SDL_Rect aSource[m_ciLastGlyph - m_ciFirstGlyph + 1];
+
+	/*
+	 * Render every character as a string of its own, which places it within
+	 * its line exactly as it would be within longer text. Only the part that
+	 * is not transparent is kept, so that the quads of adjacent characters
+	 * do not overlap. Glyphs are laid out in rows and kept one pixel apart so
+	 * that filtering doesn't pick up their neighbours.
+	 */
+	int iX = 0, iY = 0, iRowHeight = 0;
+	for (int c = m_ciFirstGlyph; c <= m_ciLastGlyph; c++) {
+		Glyph& oGlyph = m_aGlyph[c - m_ciFirstGlyph];
+		char sText[2] = { (char)c, '\0' };
+		SDL_Surface* pGlyph = TTF_RenderText_Blended(m_pFont, sText, oWhite);
+		apGlyph[c - m_ciFirstGlyph] = pGlyph;
+		if (pGlyph == NULL)
+			continue;
+		oGlyph.m_iAdvance = pGlyph->w;
+		int iMinX, iMaxX, iMinY, iMaxY, iAdvance;
+		if (TTF_GlyphMetrics(m_pFont, c, &iMinX, &iMaxX, &iMinY, &iMaxY, &iAdvance) == 0)
+			oGlyph.m_iAdvance = iAdvance;
+
+		// Find the bounding box of all pixels with some coverage
+		int iLeft = pGlyph->w, iTop = pGlyph->h, iRight = 0, iBottom = 0;
+		SDL_LockSurface(pGlyph);
+		for (int y = 0; y < pGlyph->h; y++) {
+			const uint32_t* pRow = (const uint32_t*)((const uint8_t*)pGlyph->pixels + y * pGlyph->pitch);
+			for (int x = 0; x < pGlyph->w; x++) {
+				if ((pRow[x] & pGlyph->format->Amask) == 0)
+					continue;
+				iLeft = std::min(iLeft, x); iRight = std::max(iRight, x + 1);
+				iTop = std::min(iTop, y); iBottom = std::max(iBottom, y + 1);
+			}
+		}
+		SDL_UnlockSurface(pGlyph);
+
+		// Whitespace has nothing to draw
+		if (iLeft >= iRight)
+			continue;
+		assert(iRight - iLeft <= m_ciTextureWidth);
+
+		oGlyph.m_iOffsetX = iLeft;
+		oGlyph.m_iOffsetY = iTop;
+		oGlyph.m_iWidth = iRight - iLeft;
+		oGlyph.m_iHeight = iBottom - iTop;
+		if (iX + oGlyph.m_iWidth > m_ciTextureWidth) {
+			iX = 0;
+			iY += iRowHeight + 1;
+			iRowHeight = 0;
+		}
+		aSource[c - m_ciFirstGlyph].x = iLeft;
+		aSource[c - m_ciFirstGlyph].y = iTop;
+		aSource[c - m_ciFirstGlyph].w = oGlyph.m_iWidth;
+		aSource[c - m_ciFirstGlyph].h = oGlyph.m_iHeight;
+
+		// Texture coordinates are fixed up once we know the texture size
+		oGlyph.m_fTexLeft = iX;
+		oGlyph.m_fTexTop = iY;
+		iX += oGlyph.m_iWidth + 1;
+		iRowHeight = std::max(iRowHeight, oGlyph.m_iHeight);
+	}
+	int iHeight = iY + iRowHeight;
+
+	SDL_Surface* pSurface = SDL_CreateRGBSurface(SDL_SWSURFACE, m_ciTextureWidth, std::max(iHeight, 1), 32, 0xff, 0xff00, 0xff0000, 0xff000000);
+	assert(pSurface != NULL);
+	SDL_FillRect(pSurface, NULL, 0);
+	for (int c = m_ciFirstGlyph; c <= m_ciLastGlyph; c++) {
+		SDL_Surface* pGlyph = apGlyph[c - m_ciFirstGlyph];
+		if (pGlyph == NULL)
+			continue;
+
+		// Copy the alpha channel rather than blending with it
+		Glyph& oGlyph = m_aGlyph[c - m_ciFirstGlyph];
+		if (oGlyph.m_iWidth > 0) {
+			SDL_SetAlpha(pGlyph, 0, SDL_ALPHA_OPAQUE);
+			SDL_Rect oRect;
+			oRect.x = (Sint16)oGlyph.m_fTexLeft;
+			oRect.y = (Sint16)oGlyph.m_fTexTop;
+			SDL_BlitSurface(pGlyph, &aSource[c - m_ciFirstGlyph], pSurface, &oRect);
+		}
+		SDL_FreeSurface(pGlyph);
+	}
+
+	bool bResult = m_oTexture.ConvertSurface(pSurface);
+	SDL_FreeSurface(pSurface);
+	if (!bResult)
+		return false;
+
+	float fScaleX = m_oTexture.GetNormalizedWidth() / (float)m_ciTextureWidth;
+	float fScaleY = m_oTexture.GetNormalizedHeight() / (float)std::max(iHeight, 1);
+	for (int c = m_ciFirstGlyph; c <= m_ciLastGlyph; c++) {
+		Glyph& oGlyph = m_aGlyph[c - m_ciFirstGlyph];
+		oGlyph.m_fTexRight = m_oTexture.GetNormalizedLeft() + (oGlyph.m_fTexLeft + oGlyph.m_iWidth) * fScaleX;
+		oGlyph.m_fTexBottom = m_oTexture.GetNormalizedTop() + (oGlyph.m_fTexTop + oGlyph.m_iHeight) * fScaleY;
+		oGlyph.m_fTexLeft = m_oTexture.GetNormalizedLeft() + oGlyph.m_fTexLeft * fScaleX;
+		oGlyph.m_fTexTop = m_oTexture.GetNormalizedTop() + oGlyph.m_fTexTop * fScaleY;
+	}
+
+	if (g_oApp.IsVerbose())
+		std::cerr << "glyph cache: " << (m_ciLastGlyph - m_ciFirstGlyph + 1) << " glyphs in a " << m_ciTextureWidth << "x" << iHeight << " texture\n";
+	return true;
+}
+
+int
+GlyphCache::GetTextWidth(const std::string& sText) const
+{
+	int iWidth = 0;
+	for (std::string::const_iterator it = sText.begin(); it != sText.end(); it++) {
+		int c = (unsigned char)*it;
+		if (c >= m_ciFirstGlyph)
+			iWidth += m_aGlyph[c - m_ciFirstGlyph].m_iAdvance;
+	}
+	return iWidth;
+}
+
+void
+GlyphCache::Draw(const std::string& sText, float fX, float fY, float fDepth, uint32_t uiColor)
+{
+	SpriteBatch& oBatch = g_oApp.GetSpriteBatch();
+	SpriteBatch::Blend oBlend(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLuint iTexture = m_oTexture.GetTextureID();
+
+	for (std::string::const_iterator it = sText.begin(); it != sText.end(); it++) {
+		int c = (unsigned char)*it;
+		if (c < m_ciFirstGlyph)
+			continue;
+
+		const Glyph& oGlyph = m_aGlyph[c - m_ciFirstGlyph];
+		if (oGlyph.m_iWidth > 0) {
+			float fLeft = fX + oGlyph.m_iOffsetX;
+			float fTop = fY + oGlyph.m_iOffsetY;
+			oBatch.AddRect(iTexture, oBlend,
+			 fLeft, fTop, fLeft + oGlyph.m_iWidth, fTop + oGlyph.m_iHeight, fDepth,
+			 oGlyph.m_fTexLeft, oGlyph.m_fTexTop, oGlyph.m_fTexRight, oGlyph.m_fTexBottom,
+			 uiColor);
+		}
+		fX += oGlyph.m_iAdvance;
+	}
+}
+
+/* vim:set ts=2 sw=2: */
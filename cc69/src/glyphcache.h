@@ -0,0 +1,84 @@
+#ifndef __GLYPHCACHE_H__
+#define __GLYPHCACHE_H__
+
+#include <stdint.h>
+#include <string>
+#include "texture.h"
+
+typedef struct _TTF_Font TTF_Font;
+
+/*! \brief Draws text using glyphs rasterized in advance
+ *
+ *  Every Latin-1 glyph of the font is rendered once and packed into a
+ *  single texture. Strings are then drawn as a quad per character using
+ *  the sprite batch, so changing text never involves rasterizing or
+ *  uploading anything.
+ */
+class GlyphCache
+{
+public:
+	/*! \brief Constructs an empty glyph cache
+	 *  \param pFont Font to use
+	 */
+	GlyphCache(TTF_Font* pFont);
+
+	/*! \brief Rasterizes all glyphs
+	 *  \returns true on success
+	 */
+	bool Create();
+
+	/*! \brief Retrieve the width of a string
+	 *  \param sText String to measure
+	 *  \returns Width in pixels
+	 */
+	int GetTextWidth(const std::string& sText) const;
+
+	//! \brief Retrieve the height of a line of text
+	int GetLineHeight() const { return m_iLineHeight; }
+
+	/*! \brief Adds a string to the sprite batch
+	 *  \param sText String to draw
+	 *  \param fX Left screen coordinate
+	 *  \param fY Top screen coordinate
+	 *  \param fDepth Depth, where higher values are closer to the viewer
+	 *  \param uiColor Text color, as 0xAARRGGBB
+	 */
+	void Draw(const std::string& sText, float fX, float fY, float fDepth, uint32_t uiColor);
+
+private:
+	//! \brief Placement of a single glyph
+	struct Glyph {
+		//! \brief Texture coordinates
+		float m_fTexLeft, m_fTexTop, m_fTexRight, m_fTexBottom;
+
+		//! \brief Offset of the glyph image from the pen position at the top of the line
+		int m_iOffsetX, m_iOffsetY;
+
+		//! \brief Size of the glyph image; both are 0 if there is none
+		int m_iWidth, m_iHeight;
+
+		//! \brief Distance to move the pen after this glyph
+		int m_iAdvance;
+	};
+
+	//! \brief Font used
+	TTF_Font* m_pFont;
+
+	//! \brief Texture holding all glyphs
+	Texture m_oTexture;
+
+	//! \brief Height of a line of text
+	int m_iLineHeight;
+
+	//! \brief First and last character rasterized
+	static const int m_ciFirstGlyph = 32;
+	static const int m_ciLastGlyph = 255;
+
+	//! \brief Glyphs, indexed by character minus m_ciFirstGlyph
+	Glyph m_aGlyph[m_ciLastGlyph - m_ciFirstGlyph + 1];
+
+	//! \brief Width of the glyph texture
+	static const int m_ciTextureWidth = 256;
+};
+
+#endif /* __GLYPHCACHE_H__ */
@@ -0,0 +1,186 @@
+#include "gpufireworks.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <iostream>
+#include "app.h"
+#include "glextensions.h"
+#include "image.h"
+#include "random.h"
+
+/*
+ * This mirrors FireworkEmitter and FireworkLifecycle: a rocket of size 5 is
+ * launched upwards at 5 pixels per step and decelerated by 0.03 per step;
+ * after 100 steps, every particle is given its own speed, gravity becomes
+ * 0.04 and the alpha value decreases by 0.02 per step. As the CPU version
+ * moves particles before applying gravity, the vertical distance covered
+ * after n steps is v * n + g * n * (n - 1) / 2.
+ */
+const char* GPUFireworks::m_cpVertexShader =
+	"uniform float fStep;\n"
+	"uniform vec2 vLaunch;\n"
+	"void main()\n"
+	"{\n"
+	"	float fRocket = min(fStep, 100.0);\n"
+	"	vec2 vPosition = vec2(vLaunch.x + vLaunch.y * fRocket, -5.0 * fRocket + 0.015 * fRocket * (fRocket - 1.0));\n"
+	"	float fSize = 5.0;\n"
+	"	vec4 vColor = vec4(1.0);\n"
+	"	float fExplosion = fStep - 100.0;\n"
+	"	if (fExplosion >= 0.0) {\n"
+	"		vPosition += gl_Vertex.zw * fExplosion + vec2(0.0, 0.02 * fExplosion * (fExplosion - 1.0));\n"
+	"		fSize = 3.0;\n"
+	"		vColor = vec4(gl_Color.rgb, 1.0 - 0.02 * fExplosion);\n"
+	"	}\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * vec4(vPosition + gl_Vertex.xy * fSize, 0.0, 1.0);\n"
+	"	gl_FrontColor = vColor;\n"
+	"	gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+	"}\n";
+
+GPUFireworks::GPUFireworks()
+	: m_poImage(NULL), m_hProgram(0), m_iStepLocation(-1), m_iLaunchLocation(-1),
+	  m_iBuffer(0), m_iStep(0), m_fLaunchX(0.0f)
+{
+}
+
+GPUFireworks::~GPUFireworks()
+{
+	Unload();
+	delete m_poImage;
+}
+
+bool
+GPUFireworks::IsSupported()
+{
+	return GLExtensions::HasVertexShaders() && GLExtensions::HasVertexBufferObjects();
+}
+
+bool
+GPUFireworks::Initialize()
+{
+	assert(IsSupported());
+
+	m_poImage = new Image(g_oApp.GetDataPath() + "/particle.png");
+	if (!m_poImage->Load()) {
+		std::cerr << "fatal: cannot load particle image\n";
+		exit(EXIT_FAILURE);
+	}
+
+	GLhandleARB hShader = GLExtensions::CreateShaderObject(GL_VERTEX_SHADER_ARB);
+	GLExtensions::ShaderSource(hShader, 1, (const GLcharARB**)&m_cpVertexShader, NULL);
+	GLExtensions::CompileShader(hShader);
+	m_hProgram = GLExtensions::CreateProgramObject();
+	GLExtensions::AttachObject(m_hProgram, hShader);
+	GLExtensions::LinkProgram(m_hProgram);
+
+	// The program keeps the shader alive as long as it needs it
+	GLExtensions::DeleteObject(hShader);
+
+	GLint iLinked = GL_FALSE;
+	GLExtensions::GetObjectParameteriv(m_hProgram, GL_OBJECT_LINK_STATUS_ARB, &iLinked);
+	if (!iLinked) {
+		GLcharARB aLog[1024];
+		GLExtensions::GetInfoLog(m_hProgram, sizeof(aLog), NULL, aLog);
+		std::cerr << "fireworks: cannot build vertex shader: " << aLog << "\n";
+		Unload();
+		return false;
+	}
+	m_iStepLocation = GLExtensions::GetUniformLocation(m_hProgram, "fStep");
+	m_iLaunchLocation = GLExtensions::GetUniformLocation(m_hProgram, "vLaunch");
+
+	GLExtensions::GenBuffers(1, &m_iBuffer);
+	Launch();
+	return true;
+}
+
+void
+GPUFireworks::Unload()
+{
+	if (m_iBuffer != 0) {
+		GLExtensions::DeleteBuffers(1, &m_iBuffer);
+		m_iBuffer = 0;
+	}
+	if (m_hProgram != 0) {
+		GLExtensions::DeleteObject(m_hProgram);
+		m_hProgram = 0;
+	}
+}
+
+void
+GPUFireworks::Launch()
+{
+	float fW = g_oApp.GetScreenWidth() / 2.0f;
+	m_fLaunchX = Random::Get(-fW, fW);
+	m_iStep = 0;
+
+	float fTexLeft = m_poImage->GetNormalizedLeft();
+	float fTexTop = m_poImage->GetNormalizedTop();
+	float fTexRight = fTexLeft + m_poImage->GetNormalizedWidth();
+	float fTexBottom = fTexTop + m_poImage->GetNormalizedHeight();
+	const float afU[4] = { fTexLeft, fTexRight, fTexRight, fTexLeft };
+	const float afV[4] = { fTexTop, fTexTop, fTexBottom, fTexBottom };
+	const float afDX[4] = { -1.0f, 1.0f, 1.0f, -1.0f };
+	const float afDY[4] = { -1.0f, -1.0f, 1.0f, 1.0f };
+
+	Vertex aVertex[m_ciNumParticles * 4];
+	Vertex* pVertex = aVertex;
+	for (int n = 0; n < m_ciNumParticles; n++) {
+		GLubyte aColor[4] = {
+			(GLubyte)Random::Get(0, 255), (GLubyte)Random::Get(0, 255), (GLubyte)Random::Get(0, 255), 255
+		};
+		float fSpeedX = Random::Get(-2.0f, 2.0f);
+		float fSpeedY = Random::Get(-2.0f, 2.0f);
+		for (int i = 0; i < 4; i++, pVertex++) {
+			pVertex->m_fU = afU[i];
+			pVertex->m_fV = afV[i];
+			std::copy(aColor, aColor + 4, pVertex->m_aColor);
+			pVertex->m_fCornerX = afDX[i];
+			pVertex->m_fCornerY = afDY[i];
+			pVertex->m_fSpeedX = fSpeedX;
+			pVertex->m_fSpeedY = fSpeedY;
+		}
+	}
+
+	GLExtensions::BindBuffer(GL_ARRAY_BUFFER_ARB, m_iBuffer);
+	GLExtensions::BufferData(GL_ARRAY_BUFFER_ARB, sizeof(aVertex), aVertex, GL_STATIC_DRAW_ARB);
+	GLExtensions::BindBuffer(GL_ARRAY_BUFFER_ARB, 0);
+}
+
+void
+GPUFireworks::Evolve()
+{
+	if (++m_iStep >= m_ciNumSteps)
+		Launch();
+}
+
+void
+GPUFireworks::Render()
+{
+	glBindTexture(GL_TEXTURE_2D, m_poImage->GetTextureID());
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+
+	GLExtensions::UseProgramObject(m_hProgram);
+	GLExtensions::Uniform1f(m_iStepLocation, (GLfloat)m_iStep);
+	GLExtensions::Uniform2f(m_iLaunchLocation, m_fLaunchX, (m_fLaunchX >= 0.0f) ? -2.5f : 2.5f);
+
+	// Pointers are offsets into the buffer
+	GLExtensions::BindBuffer(GL_ARRAY_BUFFER_ARB, m_iBuffer);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, m_fU));
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, m_aColor));
+	glVertexPointer(4, GL_FLOAT, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, m_fCornerX));
+	glDrawArrays(GL_QUADS, 0, m_ciNumParticles * 4);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	GLExtensions::BindBuffer(GL_ARRAY_BUFFER_ARB, 0);
+
+	GLExtensions::UseProgramObject(0);
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+	glDisable(GL_BLEND);
+}
+
+/* vim:set ts=2 sw=2: */
@@ -0,0 +1,88 @@
+#ifndef __GPUFIREWORKS_H__
+#define __GPUFIREWORKS_H__
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+class Image;
+
+/*! \brief Fireworks which are entirely animated by a vertex shader
+ *
+ *  The motion of Fireworks has a closed form: a rocket rises along a
+ *  ballistic arc, explodes after a fixed number of steps and its particles
+ *  then follow arcs of their own while fading out. Rather than simulating
+ *  every particle on the CPU, the parameters of each burst are uploaded to
+ *  a vertex buffer once and the vertex shader evaluates position, color and
+ *  alpha from the number of steps since launch. Each frame thus only sets a
+ *  single uniform and issues a single draw call.
+ *
+ *  This can only be used if IsSupported() holds; Fireworks is the fallback.
+ */
+class GPUFireworks
+{
+public:
+	//! \brief Constructs the fireworks
+	GPUFireworks();
+
+	//! \brief Destroys the fireworks
+	~GPUFireworks();
+
+	//! \brief Does the OpenGL implementation support everything we need?
+	static bool IsSupported();
+
+	/*! \brief Initializes the fireworks and launches the first rocket
+	 *  \returns true on success, false if the shader could not be built
+	 */
+	bool Initialize();
+
+	//! \brief Advances the fireworks a single step
+	void Evolve();
+
+	//! \brief Renders the fireworks
+	void Render();
+
+protected:
+	//! \brief Launches a new rocket and uploads its explosion parameters
+	void Launch();
+
+	//! \brief Frees all OpenGL resources
+	void Unload();
+
+private:
+	//! \brief Vertex as stored in the buffer
+	struct Vertex {
+		GLfloat m_fU, m_fV;
+		GLubyte m_aColor[4];
+		//! \brief Quad corner, followed by the speed after explosion
+		GLfloat m_fCornerX, m_fCornerY, m_fSpeedX, m_fSpeedY;
+	};
+
+	//! \brief Particle image
+	Image* m_poImage;
+
+	//! \brief Shader program
+	GLhandleARB m_hProgram;
+
+	//! \brief Uniform locations within the program
+	GLint m_iStepLocation, m_iLaunchLocation;
+
+	//! \brief Vertex buffer holding the current burst
+	GLuint m_iBuffer;
+
+	//! \brief Number of steps since the current rocket was launched
+	int m_iStep;
+
+	//! \brief Horizontal position at which the current rocket was launched
+	float m_fLaunchX;
+
+	//! \brief Number of particles per rocket
+	static const int m_ciNumParticles = 100;
+
+	//! \brief Number of steps before a new rocket is launched
+	static const int m_ciNumSteps = 150;
+
+	//! \brief Source of the vertex shader
+	static const char* m_cpVertexShader;
+};
+
+#endif /* __GPUFIREWORKS_H__ */
@@ -2,30 +2,58 @@
 #include <assert.h>
 #include <SDL/SDL.h>
 #include <SDL/SDL_image.h>
+#include <iostream>
 #include "app.h"
+#include "jpegloader.h"
+#include "scaler.h"
 #include "stringlibrary.h"
 
 Image::Image(const std::string& sFilename)
-	: m_sFilename(sFilename), m_bLoaded(false), m_bCorrupt(false)
+	: m_pCachePrev(NULL), m_pCacheNext(NULL), m_bCached(false),
+	  m_uiCachedSystemSize(0), m_uiCachedVideoSize(0),
+	  m_sFilename(sFilename), m_bLoaded(false), m_bCorrupt(false)
 {
 }
 
 bool
-Image::Load()
+Image::Load(TextureAtlas* pAtlas, bool bStream)
 {
 	assert(!m_bLoaded); // you shan't load twice
 	assert(!m_bCorrupt); // don't load what you know will fail
 
-	SDL_Surface* pSurface = IMG_Load(m_sFilename.c_str());
+	/*
+	 * JPEG images are decoded at the smallest size that still fills the
+	 * screen; anything libjpeg can't handle is left to SDL_image.
+	 */
+	SDL_Surface* pSurface = NULL;
+	if (JpegLoader::IsJpeg(m_sFilename))
+		pSurface = JpegLoader::Load(m_sFilename, g_oApp.GetScreenWidth(), g_oApp.GetScreenHeight());
+	if (pSurface == NULL)
+		pSurface = IMG_Load(m_sFilename.c_str());
 	if (pSurface == NULL) {
 		m_bCorrupt = true;
 		return false;
 	}
-	if (m_oTexture.ConvertSurface(pSurface))
+
+	/*
+	 * If the image is larger than the screen, scale it down here; this looks
+	 * better than having OpenGL do it and saves both memory and upload time.
+	 */
+	SDL_Surface* pScaled = Scaler::Fit(pSurface, g_oApp.GetScreenWidth(), g_oApp.GetScreenHeight());
+	if (pScaled != NULL) {
+		SDL_FreeSurface(pSurface);
+		pSurface = pScaled;
+	}
+
+	if (m_oTexture.ConvertSurface(pSurface, pAtlas, bStream))
 		m_bLoaded = true;
 	else
 		m_bCorrupt = true;
 
+	if (m_bLoaded && g_oApp.IsVerbose())
+		std::cerr << "Image: " << m_sFilename << " is " << GetWidth() << "x" << GetHeight() <<
+		 ", " << m_oTexture.GetPaddingSaved() / 1024 << "KB of texture padding saved\n";
+
 	// Throw away the SDL image; we no longer need it
 	SDL_FreeSurface(pSurface);
 	return !m_bCorrupt;
@@ -65,17 +93,12 @@ Image::CompareByFilename(const Image* pA, const Image* pB)
 }
 
 void
-Image::RenderFullScreen()
+Image::RenderFullScreen(float fDepth /* = 0.0f */, const SpriteBatch::Blend& oBlend /* = SpriteBatch::Blend() */)
 {
-	float fTexHeight = GetNormalizedHeight();
-	float fTexWidth  = GetNormalizedWidth();
-	glBindTexture(GL_TEXTURE_2D, GetTextureID());
-	glBegin(GL_QUADS);
-	glTexCoord2f(     0.0f,       0.0f); glVertex3f(0.0f, 0.0f, 0.0f);
-	glTexCoord2f(fTexWidth,       0.0f); glVertex3f(g_oApp.GetScreenWidth(), 0.0f, 0.0f);
-	glTexCoord2f(fTexWidth, fTexHeight); glVertex3f(g_oApp.GetScreenWidth(), g_oApp.GetScreenHeight(), 0.0f);
-	glTexCoord2f(     0.0f, fTexHeight); glVertex3f(0.0f, g_oApp.GetScreenHeight(), 0.0f);
-	glEnd();
+	g_oApp.GetSpriteBatch().AddRect(GetTextureID(), oBlend,
+	 0.0f, 0.0f, g_oApp.GetScreenWidth(), g_oApp.GetScreenHeight(), fDepth,
+	 GetNormalizedLeft(), GetNormalizedTop(),
+	 GetNormalizedLeft() + GetNormalizedWidth(), GetNormalizedTop() + GetNormalizedHeight());
 }
 
 /* vim:set ts=2 sw=2: */
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <boost/thread/mutex.hpp>
+#include "spritebatch.h"
 #include "texture.h"
 
 //! \brief Contains a single image
@@ -15,8 +16,11 @@ public:
 	//! \brief Destroys the image
 	~Image();
 
-	//! \brief Loads the image
-	bool Load();
+	/*! \brief Loads the image
+	 *  \param pAtlas Atlas to place the image in, if it fits
+	 *  \param bStream Stream the image through a pixel buffer; only for photo's
+	 */
+	bool Load(TextureAtlas* pAtlas = NULL, bool bStream = false);
 
 	//! \brief Unloads the image
 	void Unload();
@@ -30,6 +34,28 @@ public:
 	//! \brief Retrieve the texture ID
 	GLuint GetTextureID() { return m_oTexture.GetTextureID(); }
 
+	/*! \brief Is the image completely uploaded to the GPU?
+	 *
+	 *  Rendering an image that is not resident will upload the remainder
+	 *  at once, which may take longer than a frame.
+	 */
+	bool IsResident() { return m_oTexture.IsResident(); }
+
+	//! \brief Is there image data left to upload to the GPU?
+	bool HasPendingUpload() const { return m_oTexture.HasPendingUpload(); }
+
+	/*! \brief Uploads part of the image to the GPU
+	 *  \param iNumRows Maximum number of rows to upload
+	 *  \returns true if the image is now resident
+	 */
+	bool UploadRows(int iNumRows) { return m_oTexture.UploadRows(iNumRows); }
+
+	//! \brief Retrieve the normalized left texture coordinate
+	float GetNormalizedLeft() const { return m_oTexture.GetNormalizedLeft(); }
+
+	//! \brief Retrieve the normalized top texture coordinate
+	float GetNormalizedTop() const { return m_oTexture.GetNormalizedTop(); }
+
 	//! \brief Retrieve the normalized height
 	float GetNormalizedHeight() const { return m_oTexture.GetNormalizedHeight(); }
 
@@ -42,6 +68,12 @@ public:
 	//! \brief Retrieve the image width, in pixels
 	unsigned int GetWidth() const { return m_oTexture.GetWidth(); }
 
+	//! \brief Retrieve the amount of system memory in use, in bytes
+	size_t GetSystemMemorySize() const { return m_oTexture.GetSystemMemorySize(); }
+
+	//! \brief Retrieve the amount of video memory in use, in bytes
+	size_t GetVideoMemorySize() const { return m_oTexture.GetVideoMemorySize(); }
+
 	/*! \brief Locks the image object
 	 *
 	 *  Locking the image ensures no one will attempt to read or unload it;
@@ -49,6 +81,14 @@ public:
 	 */
 	void Lock() { m_oLock.lock(); }
 
+	/*! \brief Attempts to lock the image object
+	 *  \returns true if the lock was obtained
+	 *
+	 *  This fails if someone else holds the lock, i.e. while a decode
+	 *  worker is busy loading the image.
+	 */
+	bool TryLock() { return m_oLock.try_lock(); }
+
 	//! \brief Unlocks the image object
 	void Unlock() { m_oLock.unlock(); }
 
@@ -62,8 +102,11 @@ public:
 	//! \brief Retrieve the filename of the image
 	const std::string& GetFilename() const {return m_sFilename; }
 
-	//! \brief Renders the image full-screen
-	void RenderFullScreen();
+	/*! \brief Renders the image full-screen
+	 *  \param fDepth Depth to render at
+	 *  \param oBlend Blending to use
+	 */
+	void RenderFullScreen(float fDepth = 0.0f, const SpriteBatch::Blend& oBlend = SpriteBatch::Blend());
 
 	/*! \brief Compares two images by filename
 	 *  \params pA First image
@@ -73,6 +116,27 @@ public:
 	static bool CompareByFilename(const Image* pA, const Image* pB);
 
 private:
+	/*
+	 * The image library caches images using an intrusive LRU list; the fields
+	 * below are private to it and protected by the library lock.
+	 */
+	friend class ImageLibrary;
+
+	//! \brief Previous (more recently used) image in the cache
+	Image* m_pCachePrev;
+
+	//! \brief Next (less recently used) image in the cache
+	Image* m_pCacheNext;
+
+	//! \brief Is the image in the cache?
+	bool m_bCached;
+
+	//! \brief System memory accounted for in the cache, in bytes
+	size_t m_uiCachedSystemSize;
+
+	//! \brief Video memory accounted for in the cache, in bytes
+	size_t m_uiCachedVideoSize;
+
 	//! \brief Full path to the image
 	std::string m_sFilename;
 
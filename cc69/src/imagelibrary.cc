@@ -1,22 +1,41 @@
 #include "imagelibrary.h"
 #include "image.h"
+#include <assert.h>
+#include <iostream>
+#include <limits>
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/static_assert.hpp>
+#include "app.h"
+#include "sharedcontext.h"
 
 #include <stdio.h>
 
-ImageLibrary::ImageLibrary()
-	: m_oPreloadThread(PreloaderThreadWrapper, this),
-		m_iCurrentImage(-1)
+ImageLibrary::ImageLibrary(int iNumWorkers, size_t uiSystemBudget, size_t uiVideoBudget, int iUploadBudget)
+	: m_pCacheHead(NULL), m_pCacheTail(NULL), m_uiSystemUsage(0), m_uiVideoUsage(0),
+	  m_uiSystemBudget(uiSystemBudget), m_uiVideoBudget(uiVideoBudget), m_oUploadScheduler(iUploadBudget),
+	  m_iNumWorkers(iNumWorkers), m_bTerminating(false), m_iCurrentImage(-1),
+	  m_iPreviousImage(-1), m_iBusyWorkers(0), m_uiNumDecoded(0)
 {
+	assert(m_iNumWorkers > 0);
+	for (int i = 0; i < m_iNumWorkers; i++)
+		m_oWorkers.create_thread(boost::bind(&ImageLibrary::WorkerThread, this));
 }
 
 ImageLibrary::~ImageLibrary()
 {
-	// Ask the thread to terminate and wait until it is gone
-	m_bTerminating = true;
-	m_oCV.notify_one();
-	m_oPreloadThread.join();
+	// Ask the threads to terminate and wait until they are gone
+	{
+		boost::unique_lock<boost::mutex> oLock(m_oLock);
+		m_bTerminating = true;
+		m_oCV.notify_all();
+	}
+	m_oWorkers.join_all();
+
+	if (g_oApp.IsVerbose())
+		std::cerr << "ImageLibrary: decoded " << m_uiNumDecoded << " images using " <<
+		 m_iNumWorkers << " workers, " << GetDecodeThroughput() << " images/s, cache uses " <<
+		 m_uiSystemUsage / 1024 << "KB system and " << m_uiVideoUsage / 1024 << "KB video memory\n";
 
 	// Throw away all images we have
 	for (TImagePtrVector::iterator it = m_oImages.begin(); it != m_oImages.end(); it++)
@@ -68,129 +87,284 @@ ImageLibrary::GetLocked(int n)
 	Image* pImage = m_oImages[n];
 	pImage->Lock();
 
+	// Update our current image; this also kicks the preloader
+	SetCurrentImage(n);
+
+	// Load the image, if necessary
+	if (!pImage->IsLoaded() && !pImage->IsCorrupt())
+		pImage->Load(NULL, true);
+
+	// Add the item to the cache; this ensures it will be cleaned up as necessary
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	Touch(pImage);
+	return pImage;
+}
+
+void
+ImageLibrary::SetCurrentImage(int n)
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+
 	/*
 	 * Update our previous and current image values, but only on a change.
 	 */
-	{
-		boost::unique_lock<boost::mutex> oLock(m_oLock);
-		if (m_iCurrentImage != n) {
-			// Update our image and awake our preloader thread
-			m_iCurrentImage = n;
-			m_oCV.notify_one();
-		}
-
-		/*
-		 * If the preloader list is getting very large, throw away some images that
-		 * are no longer necessary.
-		 */
-		int iPreloadOverflow = m_oPreloadedImages.size() - 2 * (m_ciNumPreloadsPerDirection + 1);
-		TImagePtrList::iterator it(m_oPreloadedImages.begin());
-		while (iPreloadOverflow > 0 && it != m_oPreloadedImages.end()) {
-			if ((*it)->CancelPreload()) {
-				it = m_oPreloadedImages.erase(it);
-				iPreloadOverflow--;
-			} else {
-				it++;
-			}
-		}
-		assert(iPreloadOverflow <= 0);
+	if (m_iCurrentImage != n) {
+		// Update our image and awake our workers
+		m_iPreviousImage = m_iCurrentImage;
+		m_iCurrentImage = n;
+		QueuePreloads(n);
 	}
+}
 
-	// Load the image, if necessary
-	if (!pImage->IsLoaded() && !pImage->IsCorrupt() && pImage->Load()) {
-		// Add the item to the cache; this ensures it will be cleaned up as necessary
+Image*
+ImageLibrary::TryGetLocked(int n, bool bMakeCurrent /* = true */)
+{
+	assert(n >= 0 && n < m_oImages.size());
+
+	if (bMakeCurrent)
+		SetCurrentImage(n);
+
+	// If a worker is busy with the image, it is not ready
+	Image* pImage = m_oImages[n];
+	if (!pImage->TryLock())
+		return NULL;
+	if (pImage->IsLoaded() || pImage->IsCorrupt()) {
 		boost::unique_lock<boost::mutex> oLock(m_oLock);
-		m_oPreloadedImages.push_back(pImage);
+		Touch(pImage);
+		return pImage;
 	}
-	return pImage;
+	pImage->Unlock();
+
+	/*
+	 * The image is not loaded and no one is working on it; this happens if it
+	 * was thrown away after it was queued. Ensure a worker picks it up; only
+	 * the image the user is after may go ahead of the preloads.
+	 */
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	TPreloadJobQueue::iterator it = m_oPreloadQueue.begin();
+	while (it != m_oPreloadQueue.end() && it->m_iImage != n)
+		it++;
+	if (it == m_oPreloadQueue.end()) {
+		if (bMakeCurrent)
+			m_oPreloadQueue.push_front(PreloadJob(n, 0, 0));
+		else
+			m_oPreloadQueue.push_back(PreloadJob(n, 0, 0));
+		m_oCV.notify_one();
+	}
+	return NULL;
 }
 
 void
-ImageLibrary::Preload(int iCurrent, int iDirection)
-{
-	assert(iDirection == -1 || iDirection == 1);
-	assert(iCurrent >= 0 && iCurrent < m_oImages.size());
-
-	int iLoops = 0;
-	int iLeft = m_ciNumPreloadsPerDirection;
-	while (iLeft > 0 && iLoops < 2) {
-		// Figure out which index to preload
-		iCurrent += iDirection;
-		if (iCurrent < 0) {
-			iCurrent = m_oImages.size() - 1; iLoops++;
-		} else if (iCurrent >= m_oImages.size()) {
-			iCurrent = 0; iLoops++;
-		}
+ImageLibrary::Unlink(Image* pImage)
+{
+	assert(pImage->m_bCached);
 
-		// Obtain the image context and see what we can do
-		Image* pImage = m_oImages[iCurrent];
-		pImage->Lock();
-		if (!pImage->IsCorrupt()) {
-			if (!pImage->IsLoaded()) {
-				if (pImage->Load()) {
-					/*
-					 * Loading worked; add the image to the preloaded images list. This
-					 * list is used to get rid of old stuff when we are exceeding our
-					 * preload list.
-					 */
-					boost::unique_lock<boost::mutex> oLock(m_oLock);
-					m_oPreloadedImages.push_back(pImage);
-					iLeft--;
-				} /* else image was corrupt; do not update count */
-			} else {
-				/*
-				 * Image was already preloaded - we must move it to the end of the
-				 * preloaded images list to prevent it from being cleaned up.
-				 */
-				boost::unique_lock<boost::mutex> oLock(m_oLock);
-				TImagePtrList::iterator it = std::find(m_oPreloadedImages.begin(), m_oPreloadedImages.end(), pImage);
-				assert(it != m_oPreloadedImages.end());
-				m_oPreloadedImages.erase(it);
-				m_oPreloadedImages.push_back(pImage);
-				iLeft--;
-			}
-		} /* else corrupt image; these do not count */
-		pImage->Unlock();
-	}
+	if (pImage->m_pCachePrev != NULL)
+		pImage->m_pCachePrev->m_pCacheNext = pImage->m_pCacheNext;
+	else
+		m_pCacheHead = pImage->m_pCacheNext;
+	if (pImage->m_pCacheNext != NULL)
+		pImage->m_pCacheNext->m_pCachePrev = pImage->m_pCachePrev;
+	else
+		m_pCacheTail = pImage->m_pCachePrev;
+	pImage->m_pCachePrev = NULL;
+	pImage->m_pCacheNext = NULL;
+	pImage->m_bCached = false;
+
+	m_uiSystemUsage -= pImage->m_uiCachedSystemSize;
+	m_uiVideoUsage -= pImage->m_uiCachedVideoSize;
+	pImage->m_uiCachedSystemSize = 0;
+	pImage->m_uiCachedVideoSize = 0;
 }
 
 void
-ImageLibrary::PreloaderThread()
+ImageLibrary::Touch(Image* pImage)
 {
-	m_bTerminating = false;
+	if (pImage->m_bCached)
+		Unlink(pImage);
+	if (!pImage->IsLoaded())
+		return;
 
-	for (;;) {
-		int iCurrentImage;
+	/*
+	 * Re-account the image; its memory moves from system to video memory once
+	 * the texture is created, so we can't just remember what it was on load.
+	 */
+	pImage->m_uiCachedSystemSize = pImage->GetSystemMemorySize();
+	pImage->m_uiCachedVideoSize = pImage->GetVideoMemorySize();
+	m_uiSystemUsage += pImage->m_uiCachedSystemSize;
+	m_uiVideoUsage += pImage->m_uiCachedVideoSize;
 
-		{
-			// Wait until we are woken
-			boost::unique_lock<boost::mutex> oLock(m_oLock);
-			m_oCV.wait(oLock);
-			if (m_bTerminating)
-				break;
+	// Place the image at the front of the cache
+	pImage->m_pCachePrev = NULL;
+	pImage->m_pCacheNext = m_pCacheHead;
+	if (m_pCacheHead != NULL)
+		m_pCacheHead->m_pCachePrev = pImage;
+	else
+		m_pCacheTail = pImage;
+	m_pCacheHead = pImage;
+	pImage->m_bCached = true;
 
-			// See what we have to handle
-			iCurrentImage = m_iCurrentImage;
-		}
+	Evict();
+}
+
+void
+ImageLibrary::UpdateMemoryUsage(Image* pImage)
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	if (!pImage->m_bCached)
+		return;
 
+	m_uiSystemUsage -= pImage->m_uiCachedSystemSize;
+	m_uiVideoUsage -= pImage->m_uiCachedVideoSize;
+	pImage->m_uiCachedSystemSize = pImage->GetSystemMemorySize();
+	pImage->m_uiCachedVideoSize = pImage->GetVideoMemorySize();
+	m_uiSystemUsage += pImage->m_uiCachedSystemSize;
+	m_uiVideoUsage += pImage->m_uiCachedVideoSize;
+
+	Evict();
+}
+
+void
+ImageLibrary::Evict()
+{
+	Image* pCurrent = (m_iCurrentImage >= 0) ? m_oImages[m_iCurrentImage] : NULL;
+	Image* pPrevious = (m_iPreviousImage >= 0) ? m_oImages[m_iPreviousImage] : NULL;
+
+	/*
+	 * Walk from the least recently used image onwards; every image is tried
+	 * once, so images that are locked by someone else are simply skipped and
+	 * we'll get rid of them on a next attempt.
+	 */
+	Image* pImage = m_pCacheTail;
+	while (pImage != NULL && (m_uiSystemUsage > m_uiSystemBudget || m_uiVideoUsage > m_uiVideoBudget)) {
+		Image* pPrev = pImage->m_pCachePrev;
+		if (pImage != pCurrent && pImage != pPrevious && pImage->CancelPreload())
+			Unlink(pImage);
+		pImage = pPrev;
+	}
+}
+
+int
+ImageLibrary::WrapIndex(int n) const
+{
+	int iSize = m_oImages.size();
+	n %= iSize;
+	return (n < 0) ? n + iSize : n;
+}
+
+void
+ImageLibrary::QueuePreloads(int iCurrent)
+{
+	/*
+	 * The idea of the preloader is the following:
+	 *
+	 *        current image
+	 *             v
+	 * ...+-----+-----+-----+....
+	 *    |     |     |     |
+	 *    | n-1 |  n  | n+1 |
+	 *    |     |     |     |
+	 * ...+-----+-----+-----+....
+	 *
+	 * Because we don't know which direction the user will go to, we need to
+	 * preload several images around the current one. For now, we will assume
+	 * 'n' will be loaded first and we need to fill in the blanks. The
+	 * directions are interleaved so that the workers fill both windows at the
+	 * same time, nearest images first.
+	 */
+	m_oPreloadQueue.clear();
+	m_oPreloadQueue.push_back(PreloadJob(iCurrent, 0, 0));
+	for (int i = 1; i <= m_ciNumPreloadsPerDirection; i++) {
+		m_oPreloadQueue.push_back(PreloadJob(WrapIndex(iCurrent + i),  1, i));
+		m_oPreloadQueue.push_back(PreloadJob(WrapIndex(iCurrent - i), -1, i));
+	}
+	m_oCV.notify_all();
+}
+
+void
+ImageLibrary::Preload(const PreloadJob& oJob)
+{
+	assert(oJob.m_iDirection >= -1 && oJob.m_iDirection <= 1);
+	assert(oJob.m_iImage >= 0 && oJob.m_iImage < m_oImages.size());
+
+	// Obtain the image context and see what we can do
+	Image* pImage = m_oImages[oJob.m_iImage];
+	pImage->Lock();
+	bool bDecoded = !pImage->IsCorrupt() && !pImage->IsLoaded() && pImage->Load(NULL, true);
+
+	/*
+	 * If we can have an OpenGL context of our own, upload the image right
+	 * away; otherwise, the main thread will have to do it.
+	 */
+	bool bUploaded = false;
+	if (bDecoded && SharedContext::Attach()) {
+		pImage->UploadRows(std::numeric_limits<int>::max());
+		bUploaded = true;
+	}
+	{
 		/*
-		 * The idea of the preloader is the following:
-		 *
-		 *        current image
-		 *             v
-		 * ...+-----+-----+-----+....
-		 *    |     |     |     |
-		 *    | n-1 |  n  | n+2 |
-		 *    |     |     |     |
-		 * ...+-----+-----+-----+....
-		 *
-		 * Because we don't know which direction the user will go to, we need to
-		 * preload several images around the current one. For now, we will assume
-		 * 'n' has been loaded already and we need to fill in the blanks.
+		 * Either we just loaded the image, or it was already preloaded; in both
+		 * cases it must become the most recently used to prevent it from being
+		 * cleaned up.
 		 */
-		Preload(iCurrentImage,  1);
-		Preload(iCurrentImage, -1);
+		boost::unique_lock<boost::mutex> oLock(m_oLock);
+		Touch(pImage);
+		if (bDecoded)
+			m_uiNumDecoded++;
 	}
+	if (bDecoded && !bUploaded)
+		m_oUploadScheduler.Queue(pImage);
+	bool bCorrupt = pImage->IsCorrupt();
+	pImage->Unlock();
+
+	/*
+	 * Corrupt images do not count; queue the next one in the same direction
+	 * instead, unless we would wrap around the entire library. The current
+	 * image is skipped by the viewer itself.
+	 */
+	if (bCorrupt && oJob.m_iDirection != 0 && oJob.m_iDistance < m_oImages.size()) {
+		boost::unique_lock<boost::mutex> oLock(m_oLock);
+		m_oPreloadQueue.push_back(PreloadJob(WrapIndex(oJob.m_iImage + oJob.m_iDirection), oJob.m_iDirection, oJob.m_iDistance + 1));
+		m_oCV.notify_one();
+	}
+}
+
+void
+ImageLibrary::WorkerThread()
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	for (;;) {
+		// Wait until there is something to do
+		while (!m_bTerminating && m_oPreloadQueue.empty())
+			m_oCV.wait(oLock);
+		if (m_bTerminating)
+			break;
+
+		PreloadJob oJob(m_oPreloadQueue.front());
+		m_oPreloadQueue.pop_front();
+		if (m_iBusyWorkers++ == 0)
+			m_oBusySince = boost::posix_time::microsec_clock::universal_time();
+
+		// Decode without holding the library lock; other workers may proceed
+		oLock.unlock();
+		Preload(oJob);
+		oLock.lock();
+
+		if (--m_iBusyWorkers == 0)
+			m_oBusyTime += boost::posix_time::microsec_clock::universal_time() - m_oBusySince;
+	}
+}
+
+float
+ImageLibrary::GetDecodeThroughput()
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	boost::posix_time::time_duration oBusyTime(m_oBusyTime);
+	if (m_iBusyWorkers > 0)
+		oBusyTime += boost::posix_time::microsec_clock::universal_time() - m_oBusySince;
+	if (oBusyTime.total_microseconds() == 0)
+		return 0.0f;
+	return (float)m_uiNumDecoded / (oBusyTime.total_microseconds() / 1000000.0f);
 }
 
 void
@@ -1,19 +1,27 @@
 #ifndef __IMAGELIST_H__
 #define __IMAGELIST_H__
 
+#include <deque>
 #include <vector>
 #include <string>
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include "uploadscheduler.h"
 
 class Image;
 
 class ImageLibrary
 {
 public:
-	//! \brief Initializes a new image library
-	ImageLibrary();
+	/*! \brief Initializes a new image library
+	 *  \param iNumWorkers Number of decode worker threads to use
+	 *  \param uiSystemBudget Amount of system memory the cache may use, in bytes
+	 *  \param uiVideoBudget Amount of video memory the cache may use, in bytes
+	 *  \param iUploadBudget Time that may be spent uploading per frame, in microseconds
+	 */
+	ImageLibrary(int iNumWorkers, size_t uiSystemBudget, size_t uiVideoBudget, int iUploadBudget);
 
 	//! \brief Destroys the image library and everything inside it
 	~ImageLibrary();
@@ -37,54 +45,198 @@ public:
 	 */
 	Image* GetLocked(int n);
 
+	/*! \brief Return a given image number if it is ready, without blocking
+	 *  \param n Image number to obtain
+	 *  \param bMakeCurrent If true, preloading will be centered around n
+	 *  \returns Image on success or NULL if it is not ready yet
+	 *
+	 *  This never waits for an image to be decoded; if the image is not yet
+	 *  loaded, it will be handed to the decode workers and NULL is returned.
+	 *  Unless bMakeCurrent is set, it is decoded after the pending preloads.
+	 *  A returned image is either loaded or corrupt; it is locked and must be
+	 *  unlocked after use.
+	 */
+	Image* TryGetLocked(int n, bool bMakeCurrent = true);
+
+	//! \brief Retrieve the number of decode worker threads
+	int GetNumWorkers() const { return m_iNumWorkers; }
+
+	//! \brief Retrieve the number of images that may be preloaded at once
+	static int GetMaximumPreloads() { return 2 * m_ciNumPreloadsPerDirection + 1; }
+
+	/*! \brief Retrieve the decode throughput, in images per second
+	 *
+	 *  This is measured over the time at least one worker was busy
+	 *  decoding, so idle time between requests is not taken into account.
+	 */
+	float GetDecodeThroughput();
+
+	//! \brief Retrieve the amount of system memory used by cached images, in bytes
+	size_t GetSystemMemoryUsage() const { return m_uiSystemUsage; }
+
+	//! \brief Retrieve the amount of video memory used by cached images, in bytes
+	size_t GetVideoMemoryUsage() const { return m_uiVideoUsage; }
+
+	/*! \brief Retrieve the scheduler uploading decoded images
+	 *
+	 *  Its Process() function must be called every frame while images are
+	 *  being displayed.
+	 */
+	UploadScheduler& GetUploadScheduler() { return m_oUploadScheduler; }
+
+	/*! \brief Re-accounts the memory used by an image
+	 *  \param pImage Image to account, which must be locked by the caller
+	 *
+	 *  This must be called whenever rows of an image were uploaded outside
+	 *  of the decode workers, as that moves memory from system to video
+	 *  memory. Images are evicted as needed afterwards.
+	 */
+	void UpdateMemoryUsage(Image* pImage);
+
 protected:
-	//! \brief Thread taking care of the preloader actions
-	void PreloaderThread();
+	//! \brief Thread taking care of decoding preloaded images
+	void WorkerThread();
+
+	/*! \brief Queues preloads around a given image
+	 *  \param iCurrent Current image index
+	 *
+	 *  Any preloads still queued are discarded. The current image itself is
+	 *  queued first, so that it will be loaded in case no one else does.
+	 *  This must be called with m_oLock held.
+	 */
+	void QueuePreloads(int iCurrent);
+
+	/*! \brief Updates the current image
+	 *  \param n New current image
+	 *
+	 *  This re-queues the preloads if the current image changed.
+	 */
+	void SetCurrentImage(int n);
+
+	/*! \brief Marks an image as most recently used
+	 *  \param pImage Image to mark, which must be locked by the caller
+	 *
+	 *  This (re-)accounts the memory used by the image and moves it to the
+	 *  front of the cache; images that are not loaded are removed from the
+	 *  cache instead. Afterwards, images are evicted as needed to stay within
+	 *  the memory budget. This must be called with m_oLock held.
+	 */
+	void Touch(Image* pImage);
 
-	/*! \brief Preloads images
-	 *  \param iStart First image index to preload
-	 *  \param iDirection Direction to go
+	/*! \brief Removes an image from the cache
 	 *
-	 *  iDirection must be -1 or 1 and indicates whether iStart will be
-	 *  incremented or decremented;
+	 *  This must be called with m_oLock held.
 	 */
-	void Preload(int iStart, int iDirection);
+	void Unlink(Image* pImage);
+
+	/*! \brief Evicts least recently used images until we are within budget
+	 *
+	 *  Images which are locked are skipped rather than waited for, as are
+	 *  the current and previous image; the latter may still be drawn while
+	 *  animating to the current one. This must be called with m_oLock held.
+	 */
+	void Evict();
+
+	//! \brief A single image to be preloaded by a worker
+	struct PreloadJob {
+		PreloadJob(int iImage, int iDirection, int iDistance)
+		 : m_iImage(iImage), m_iDirection(iDirection), m_iDistance(iDistance)
+		{
+		}
+
+		//! \brief Image index to preload
+		int m_iImage;
+
+		//! \brief Direction we were going, -1 or 1 (0 for the current image)
+		int m_iDirection;
+
+		//! \brief Distance from the image that was current when queued
+		int m_iDistance;
+	};
+
+	/*! \brief Preloads a single image
+	 *  \param oJob Job to handle
+	 *
+	 *  If the image turns out to be corrupt, the next image in the same
+	 *  direction is queued instead; corrupt images do not count towards
+	 *  the number of images to preload. Preloaded images end up in the
+	 *  cache.
+	 */
+	void Preload(const PreloadJob& oJob);
+
+	//! \brief Wraps an image index to the library size
+	int WrapIndex(int n) const;
 
 private:
 	typedef std::vector<Image*> TImagePtrVector;
-	typedef std::list<Image*> TImagePtrList;
+	typedef std::deque<PreloadJob> TPreloadJobQueue;
 
 	//! \brief Vector containing all available images
 	TImagePtrVector m_oImages;
 
-	//! \brief List containing preloaded images
-	TImagePtrList m_oPreloadedImages;
+	//! \brief Most recently used image in the cache
+	Image* m_pCacheHead;
+
+	//! \brief Least recently used image in the cache
+	Image* m_pCacheTail;
+
+	//! \brief System memory used by cached images, in bytes
+	size_t m_uiSystemUsage;
+
+	//! \brief Video memory used by cached images, in bytes
+	size_t m_uiVideoUsage;
+
+	//! \brief Amount of system memory the cache may use, in bytes
+	size_t m_uiSystemBudget;
+
+	//! \brief Amount of video memory the cache may use, in bytes
+	size_t m_uiVideoBudget;
+
+	//! \brief Pending preload jobs, nearest images first
+	TPreloadJobQueue m_oPreloadQueue;
+
+	//! \brief Scheduler uploading decoded images to the GPU
+	UploadScheduler m_oUploadScheduler;
 
 	//! \brief Lock protecting the image library
 	boost::mutex m_oLock;
 
-	//! \brief Condition variable used to wake the preloader thread
+	//! \brief Condition variable used to wake the worker threads
 	boost::condition_variable m_oCV;
 
-	//! \brief Preloader thread
-	boost::thread m_oPreloadThread;
+	//! \brief Decode worker threads
+	boost::thread_group m_oWorkers;
 
-	//! \brief Should our thread be exiting?
-	bool m_bTerminating;
+	//! \brief Number of decode worker threads
+	int m_iNumWorkers;
 
-	//! \brief Wrapper for the preloader thread
-	static void PreloaderThreadWrapper(void* pMe) {
-		((ImageLibrary*)pMe)->PreloaderThread();
-	}
+	//! \brief Should our threads be exiting?
+	bool m_bTerminating;
 
 	//! \brief Current image being requested
 	int m_iCurrentImage;
 
+	//! \brief Image which was current before m_iCurrentImage, -1 if none
+	int m_iPreviousImage;
+
+	//! \brief Number of workers currently decoding
+	int m_iBusyWorkers;
+
+	//! \brief Number of images decoded by the workers
+	unsigned int m_uiNumDecoded;
+
+	//! \brief Moment at which the workers became busy
+	boost::posix_time::ptime m_oBusySince;
+
+	//! \brief Total time at least one worker was busy
+	boost::posix_time::time_duration m_oBusyTime;
+
 	/*! \brief Number of images being preloaded per direction
 	 *
 	 *  For example, using 3 will result in 7 images in memory: the 3
 	 *  before the current image, the 3 after the current image, and of
-	 *  course the current image itself.
+	 *  course the current image itself - provided they fit in the memory
+	 *  budget.
 	 */
 	static const int m_ciNumPreloadsPerDirection = 3;
 };
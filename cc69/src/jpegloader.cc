@@ -0,0 +1,119 @@
+#include "jpegloader.h"
+#include <SDL/SDL.h>
+#include <assert.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <strings.h>
+#include <jpeglib.h>
+#include "scaler.h"
+
+namespace {
+
+//! \brief Error manager which returns control to us instead of calling exit()
+struct ErrorManager {
+	struct jpeg_error_mgr m_oManager;
+	jmp_buf m_oJumpBuffer;
+};
+
+void
+ErrorExit(j_common_ptr pInfo)
+{
+	ErrorManager* pManager = (ErrorManager*)pInfo->err;
+	longjmp(pManager->m_oJumpBuffer, 1);
+}
+
+void
+OutputMessage(j_common_ptr /* pInfo */)
+{
+	// Corrupt data warnings are not interesting to us
+}
+
+}
+
+bool
+JpegLoader::IsJpeg(const std::string& sPath)
+{
+	size_t sDot = sPath.find_last_of('.');
+	if (sDot == std::string::npos)
+		return false;
+	const char* pExtension = sPath.c_str() + sDot + 1;
+	return strcasecmp(pExtension, "jpg") == 0 || strcasecmp(pExtension, "jpeg") == 0;
+}
+
+SDL_Surface*
+JpegLoader::Load(const std::string& sPath, int iWidth, int iHeight)
+{
+	FILE* pFile = fopen(sPath.c_str(), "rb");
+	if (pFile == NULL)
+		return NULL;
+
+	/*
+	 * Note that everything touched after setjmp() must be volatile or set up
+	 * before it, as longjmp() may clobber it otherwise.
+	 */
+	struct jpeg_decompress_struct oInfo;
+	ErrorManager oError;
+	SDL_Surface* volatile pSurface = NULL;
+	oInfo.err = jpeg_std_error(&oError.m_oManager);
+	oError.m_oManager.error_exit = ErrorExit;
+	oError.m_oManager.output_message = OutputMessage;
+	if (setjmp(oError.m_oJumpBuffer)) {
+		// Something went wrong while decoding; throw everything away
+		jpeg_destroy_decompress(&oInfo);
+		fclose(pFile);
+		if (pSurface != NULL)
+			SDL_FreeSurface(pSurface);
+		return NULL;
+	}
+
+	jpeg_create_decompress(&oInfo);
+	jpeg_stdio_src(&oInfo, pFile);
+	jpeg_read_header(&oInfo, TRUE);
+	if (oInfo.num_components != 3) {
+		// Grayscale and CMYK are left to SDL_image
+		jpeg_destroy_decompress(&oInfo);
+		fclose(pFile);
+		return NULL;
+	}
+	oInfo.out_color_space = JCS_RGB;
+	oInfo.dct_method = JDCT_IFAST;
+
+	// Figure out how large the image will be on screen
+	int iTargetWidth, iTargetHeight;
+	Scaler::CalculateFit(oInfo.image_width, oInfo.image_height, iWidth, iHeight, iTargetWidth, iTargetHeight);
+
+	/*
+	 * Pick the smallest scale libjpeg offers that still covers the target
+	 * size; the scaled IDCT yields identical quality to scaling afterwards, at
+	 * a fraction of the decoding time and memory.
+	 */
+	oInfo.scale_num = 1;
+	for (unsigned int uiDenom = 8; uiDenom > 1; uiDenom /= 2) {
+		oInfo.scale_denom = uiDenom;
+		jpeg_calc_output_dimensions(&oInfo);
+		if ((int)oInfo.output_width >= iTargetWidth && (int)oInfo.output_height >= iTargetHeight)
+			break;
+		oInfo.scale_denom = 1;
+	}
+
+	jpeg_start_decompress(&oInfo);
+	pSurface = SDL_CreateRGBSurface(SDL_SWSURFACE, oInfo.output_width, oInfo.output_height, 24, 0x0000ff, 0x00ff00, 0xff0000, 0);
+	if (pSurface == NULL) {
+		jpeg_destroy_decompress(&oInfo);
+		fclose(pFile);
+		return NULL;
+	}
+
+	// Decode straight into the surface
+	while (oInfo.output_scanline < oInfo.output_height) {
+		JSAMPROW pRow = (JSAMPROW)((uint8_t*)pSurface->pixels + oInfo.output_scanline * pSurface->pitch);
+		jpeg_read_scanlines(&oInfo, &pRow, 1);
+	}
+
+	jpeg_finish_decompress(&oInfo);
+	jpeg_destroy_decompress(&oInfo);
+	fclose(pFile);
+	return pSurface;
+}
+
+/* vim:set ts=2 sw=2: */
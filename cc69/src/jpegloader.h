@@ -0,0 +1,37 @@
+#ifndef __JPEGLOADER_H__
+#define __JPEGLOADER_H__
+
+#include <string>
+
+typedef struct SDL_Surface SDL_Surface;
+
+/*! \brief Loads JPEG images using libjpeg
+ *
+ *  Unlike IMG_Load(), this lets libjpeg perform the inverse DCT at 1/2, 1/4
+ *  or 1/8 of the original size if the image is larger than we can display
+ *  anyway; this is a lot faster and needs far less memory.
+ */
+class JpegLoader
+{
+public:
+	/*! \brief Checks whether a file looks like a JPEG image
+	 *  \param sPath Path to the file
+	 *  \returns true if the file has a JPEG extension
+	 */
+	static bool IsJpeg(const std::string& sPath);
+
+	/*! \brief Loads a JPEG image
+	 *  \param sPath Path to the file
+	 *  \param iWidth Width the image will be displayed at, in pixels
+	 *  \param iHeight Height the image will be displayed at, in pixels
+	 *  \returns 24-bit RGB surface on success or NULL on failure
+	 *
+	 *  The image is scaled down as far as possible while still covering the
+	 *  image as it would be fit into a iWidth x iHeight area; use Scaler to
+	 *  get the exact size. Only RGB images
+	 *  are handled; NULL is returned for anything else.
+	 */
+	static SDL_Surface* Load(const std::string& sPath, int iWidth, int iHeight);
+};
+
+#endif /* __JPEGLOADER_H__ */
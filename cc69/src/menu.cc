@@ -5,10 +5,13 @@
 #include "app.h"
 #include "events.h"
 #include "fireworks.h"
+#include "gpufireworks.h"
 #include "image.h"
 #include "messagewindow.h"
+#include "spritebatch.h"
 
 Fireworks* m_poFireworks;
+GPUFireworks* m_poGPUFireworks;
 
 Menu::Menu()
 	: m_poBackgroundImage(NULL)
@@ -16,11 +19,13 @@ Menu::Menu()
 	for (int i = 0; i < m_ciNumOptions; i++)
 		m_poOption[i] = NULL;
 	m_poFireworks = NULL;
+	m_poGPUFireworks = NULL;
 }
 
 Menu::~Menu()
 {
 	assert(m_poFireworks == NULL);
+	assert(m_poGPUFireworks == NULL);
 	assert(m_poBackgroundImage == NULL);
 	for (int i = 0; i < m_ciNumOptions; i++)
 		assert(m_poOption[i] == NULL);
@@ -34,7 +39,6 @@ Menu::Init()
 	float fOptionHeight = (g_oApp.GetScreenWidth() * 0.5f) / (m_ciNumOptions + 2);
 	for (int i = 0; i < m_ciNumOptions; i++) {
 		m_poOption[i] = new MessageWindow(fOptionWidth, fOptionHeight, 10.0f);
-		m_poOption[i]->Create();
 		m_poOption[i]->SetPosition(
 		 (g_oApp.GetScreenWidth() - fOptionWidth) / 2.0f,
 		 (g_oApp.GetScreenHeight() * 0.5f) + (fOptionHeight * 1.25f) * i
@@ -51,9 +55,20 @@ Menu::Init()
 		exit(EXIT_FAILURE);
 	}
 
-	m_poFireworks = new Fireworks();
-	m_poFireworks->Initialize();
+	// Let the GPU animate the fireworks if it can; simulate them otherwise
+	if (GPUFireworks::IsSupported()) {
+		m_poGPUFireworks = new GPUFireworks();
+		if (!m_poGPUFireworks->Initialize()) {
+			delete m_poGPUFireworks;
+			m_poGPUFireworks = NULL;
+		}
+	}
+	if (m_poGPUFireworks == NULL) {
+		m_poFireworks = new Fireworks();
+		m_poFireworks->Initialize();
+	}
 
+	m_iSelectedOption = -1;
 	g_oApp.GetEvents().SetLEDs(false, false);
 }
 
@@ -68,10 +83,12 @@ Menu::Cleanup()
 	m_poBackgroundImage = NULL;
 	delete m_poFireworks;
 	m_poFireworks = NULL;
+	delete m_poGPUFireworks;
+	m_poGPUFireworks = NULL;
 }
 
 void
-Menu::Render()
+Menu::Render(float /* fAlpha */)
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glLoadIdentity();
@@ -84,11 +101,13 @@ Menu::Render()
 	for (int i = 0; i < m_ciNumOptions; i++)
 		m_poOption[i]->Render();
 
+	// Fireworks are drawn directly, so anything batched must go first
+	g_oApp.GetSpriteBatch().Flush();
 	glTranslatef(g_oApp.GetScreenWidth() / 2.0f, g_oApp.GetScreenHeight() / 2.0f, 0.2f);
-	m_poFireworks->Render();
-
-	// Render
-	SDL_GL_SwapBuffers();
+	if (m_poGPUFireworks != NULL)
+		m_poGPUFireworks->Render();
+	else
+		m_poFireworks->Render();
 }
 
 void
@@ -97,7 +116,10 @@ Menu::HandleEvents()
 	Events& oEvents = g_oApp.GetEvents();
 	oEvents.Process();
 
-	m_poFireworks->Evolve();
+	if (m_poGPUFireworks != NULL)
+		m_poGPUFireworks->Evolve();
+	else
+		m_poFireworks->Evolve();
 
 	if (oEvents.CheckAndResetExit()) {
 		m_iSelectedOption = 2;
@@ -124,14 +146,9 @@ Menu::HandleEvents()
 }
 
 void
-Menu::Run()
+Menu::Update(float /* fStep */)
 {
-	m_iSelectedOption = -1;
-	while(m_iSelectedOption < 0) {
-		HandleEvents();
-		Render();
-		SDL_Delay(1000 / g_oApp.GetDesiredFPS());
-	}
+	HandleEvents();
 }
 
 /* vim:set ts=2 sw=2: */
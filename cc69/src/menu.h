@@ -14,7 +14,9 @@ public:
 
 	virtual void Init();
 	virtual void Cleanup();
-	virtual void Run();
+	virtual void Update(float fStep);
+	virtual void Render(float fAlpha);
+	virtual bool IsFinished() { return m_iSelectedOption >= 0; }
 
 	int GetSelectedOption() const { return m_iSelectedOption; }
 
@@ -24,7 +26,6 @@ public:
 
 protected:
 	void HandleEvents();
-	void Render();
 
 private:
 	//! \brief Number of menu options
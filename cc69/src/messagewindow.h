@@ -2,7 +2,6 @@
 #define __MESSAGEWINDOW_H__
 
 #include <string>
-#include "texture.h"
 
 class MessageWindow
 {
@@ -13,9 +12,6 @@ public:
 	//! \brief Destroys the message window
 	~MessageWindow();
 
-	//! \brief Creates our message window
-	void Create();
-
 	//! \brief Sets the message window position
 	void SetPosition(float fX, float fY);
 
@@ -32,8 +28,10 @@ public:
 
 	/*! \brief Updates the message window text
 	 *  \param sMessage Message to use
+	 *
+	 *  This is cheap; the text is drawn from the glyph cache.
 	 */
-	void Update(const std::string& sMessage);
+	void Update(const std::string& sMessage) { m_sMessage = sMessage; }
 
 	//! \brief Renders the object
 	void Render();
@@ -51,12 +49,6 @@ public:
 	float GetWidth() { return m_iWidth; }
 
 private:
-	//! \brief Texture used
-	Texture m_oTexture;
-
-	//! \brief SDL surface used
-	SDL_Surface* m_pSurface;
-
 	//! \brief Current text
 	std::string m_sMessage; 
 
@@ -75,9 +67,6 @@ private:
 	//! \brief Text Y coordinate, or -1 to center
 	int m_iTextY;
 
-	//! \brief Background color
-	static const unsigned int m_iBackgroundColor = 0x80909090;
-
 	//! \brief Text color
 	static const unsigned int m_iTextColor = 0x000000;
 
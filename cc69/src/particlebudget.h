@@ -0,0 +1,45 @@
+#ifndef __PARTICLEBUDGET_H__
+#define __PARTICLEBUDGET_H__
+
+#include <assert.h>
+
+/*! \brief Limits the number of particles of several stores combined
+ *
+ *  Every ParticleStore using the budget takes a particle from it when one
+ *  is added and returns it when it dies, so that concurrent effects cannot
+ *  together exceed what we can afford to draw. It must only be used by the
+ *  main thread.
+ */
+class ParticleBudget
+{
+public:
+	/*! \brief Constructs a new budget
+	 *  \param iNumParticles Number of particles available
+	 */
+	ParticleBudget(int iNumParticles) : m_iAvailable(iNumParticles) { }
+
+	/*! \brief Takes a particle from the budget
+	 *  \returns true on success, false if the budget is exhausted
+	 */
+	bool Acquire() {
+		if (m_iAvailable == 0)
+			return false;
+		m_iAvailable--;
+		return true;
+	}
+
+	//! \brief Returns particles to the budget
+	void Release(int iNumParticles) {
+		assert(iNumParticles >= 0);
+		m_iAvailable += iNumParticles;
+	}
+
+	//! \brief Retrieve the number of particles available
+	int GetAvailable() const { return m_iAvailable; }
+
+private:
+	//! \brief Number of particles available
+	int m_iAvailable;
+};
+
+#endif /* __PARTICLEBUDGET_H__ */
@@ -0,0 +1,87 @@
+#include "particleengine.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <iostream>
+#include "app.h"
+#include "image.h"
+
+ParticleEngine::ParticleEngine(int iCount, ParticleBudget* pBudget)
+	: m_oStore(iCount, pBudget), m_poImage(NULL)
+{
+}
+
+ParticleEngine::~ParticleEngine()
+{
+	delete m_poImage;
+}
+
+void
+ParticleEngine::Initialize()
+{
+	m_poImage = new Image(g_oApp.GetDataPath() + "/particle.png");
+	if (!m_poImage->Load()) {
+		std::cerr << "fatal: cannot load particle image\n";
+		exit(EXIT_FAILURE);
+	}
+}
+
+void
+ParticleEngine::Render()
+{
+	int iNumParticles = m_oStore.GetNumParticles();
+	if (iNumParticles == 0)
+		return;
+
+	float fTexLeft = m_poImage->GetNormalizedLeft();
+	float fTexTop = m_poImage->GetNormalizedTop();
+	float fTexRight = fTexLeft + m_poImage->GetNormalizedWidth();
+	float fTexBottom = fTexTop + m_poImage->GetNormalizedHeight();
+	const float afU[4] = { fTexLeft, fTexRight, fTexRight, fTexLeft };
+	const float afV[4] = { fTexTop, fTexTop, fTexBottom, fTexBottom };
+	const float afDX[4] = { -1.0f, 1.0f, 1.0f, -1.0f };
+	const float afDY[4] = { -1.0f, -1.0f, 1.0f, 1.0f };
+
+	const float* pX = m_oStore.GetX();
+	const float* pY = m_oStore.GetY();
+	const float* pSize = m_oStore.GetSize();
+	const float* pR = m_oStore.GetR();
+	const float* pG = m_oStore.GetG();
+	const float* pB = m_oStore.GetB();
+	const float* pA = m_oStore.GetA();
+
+	m_oVertices.resize(iNumParticles * 4);
+	Vertex* pVertex = &m_oVertices.front();
+	for (int n = 0; n < iNumParticles; n++) {
+		// Alpha goes below zero as particles fade out
+		GLubyte aColor[4] = {
+			(GLubyte)(std::max(0.0f, std::min(pR[n], 1.0f)) * 255.0f),
+			(GLubyte)(std::max(0.0f, std::min(pG[n], 1.0f)) * 255.0f),
+			(GLubyte)(std::max(0.0f, std::min(pB[n], 1.0f)) * 255.0f),
+			(GLubyte)(std::max(0.0f, std::min(pA[n], 1.0f)) * 255.0f)
+		};
+		for (int i = 0; i < 4; i++, pVertex++) {
+			pVertex->m_fU = afU[i];
+			pVertex->m_fV = afV[i];
+			std::copy(aColor, aColor + 4, pVertex->m_aColor);
+			pVertex->m_fX = pX[n] + afDX[i] * pSize[n];
+			pVertex->m_fY = pY[n] + afDY[i] * pSize[n];
+			pVertex->m_fZ = 0.0f;
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, m_poImage->GetTextureID());
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+
+	glInterleavedArrays(GL_T2F_C4UB_V3F, 0, &m_oVertices.front());
+	glDrawArrays(GL_QUADS, 0, m_oVertices.size());
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	// Reset the color so our next renderer needn't bother
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+	glDisable(GL_BLEND);
+}
+
+/* vim:set ts=2 sw=2: */
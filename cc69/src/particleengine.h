@@ -1,57 +1,61 @@
 #ifndef __PARTICLE_ENGINE_H__
 #define __PARTICLE_ENGINE_H__
 
-#include <list>
-#include "image.h"
+#include <GL/gl.h>
+#include <vector>
+#include "particlestore.h"
 
 class Image;
 
-template<class PARTICLE> class ParticleEngine
+/*! \brief Stores and draws particles
+ *
+ *  This takes care of everything which does not depend on how particles
+ *  behave; see ParticleSystem for that.
+ */
+class ParticleEngine
 {
 public:
 	/*! \brief Initializes the particle engine
 	 *  \param iCount Number of particles to maintain
+	 *  \param pBudget Budget shared with other engines, if any
 	 */
-	ParticleEngine(int iCount);
+	ParticleEngine(int iCount, ParticleBudget* pBudget = NULL);
 
 	//! \brief Destroys the particle engine
-	~ParticleEngine();
-
-	//! \brief Evolves the particle engine to the next phase
-	virtual void Evolve();
+	virtual ~ParticleEngine();
 
 	//! \brief Initializes the particle system
-	virtual void Initialize();
+	void Initialize();
 
-	//! \brief Renders all particles
+	/*! \brief Renders all particles
+	 *
+	 *  All particles are drawn using a single vertex array call; this uses
+	 *  the current modelview matrix.
+	 */
 	void Render();
 
-protected:
 	//! \brief Resets all particles to dead state
-	virtual void Reset();
+	void Reset() { m_oStore.Clear(); }
 
-	/*! \brief Called when all particles are dead
-	 *
-	 *  This is only called after Evolve() kills the last particle.
-	 */
-	virtual void OnAllParticlesDead() { }
-
-	//! \brief Adds a new particle
-	PARTICLE& AddParticle();
+	//! \brief Retrieve the particles
+	ParticleStore& GetStore() { return m_oStore; }
 
 private:
-	typedef std::list<PARTICLE> TParticleList;
-
-	//! \brief Active particles
-	TParticleList m_oActiveParticle;
+	//! \brief Vertex layout used to draw particles, as expected by GL_T2F_C4UB_V3F
+	struct Vertex {
+		GLfloat m_fU, m_fV;
+		GLubyte m_aColor[4];
+		GLfloat m_fX, m_fY, m_fZ;
+	};
 
-	//! \brief Dead particles
-	TParticleList m_oDeadParticle;
+	//! \brief All particles
+	ParticleStore m_oStore;
 
 	//! \brief Particle image
 	Image* m_poImage;
-};
 
-#include "particleengine.inl"
+	//! \brief Vertices of all particles, as drawn by Render()
+	std::vector<Vertex> m_oVertices;
+};
 
 #endif /* __PARTICLE_ENGINE_H__ */
@@ -0,0 +1,48 @@
+#ifndef __PARTICLEPOLICIES_H__
+#define __PARTICLEPOLICIES_H__
+
+#include "particlestore.h"
+
+/*
+ * Generic policies for use with ParticleSystem; effects combine these with
+ * policies of their own.
+ */
+
+//! \brief Emitter which never adds any particles
+struct NoEmitter {
+	void Emit(ParticleStore& /* oStore */) { }
+};
+
+//! \brief Integrator applying speed, gravity and decay
+struct BallisticIntegrator {
+	void Integrate(ParticleStore& oStore) { oStore.Integrate(); }
+};
+
+//! \brief Fade policy which leaves particles as they are
+struct NoFade {
+	void Fade(ParticleStore& /* oStore */, int /* n */) { }
+};
+
+/*! \brief Fade policy decreasing the alpha value every step
+ *
+ *  Particles whose state is below iFromState are left alone.
+ */
+template<int iFromState = 0>
+struct LinearAlphaFade {
+	LinearAlphaFade() : m_fStep(0.02f) { }
+
+	void Fade(ParticleStore& oStore, int n) {
+		if (oStore.GetState()[n] >= iFromState)
+			oStore.GetA()[n] -= m_fStep;
+	}
+
+	//! \brief Alpha value subtracted every step
+	float m_fStep;
+};
+
+//! \brief Lifecycle in which particles simply die
+struct DieLifecycle {
+	bool OnDeath(ParticleStore& /* oStore */, int /* n */) { return false; }
+};
+
+#endif /* __PARTICLEPOLICIES_H__ */
@@ -0,0 +1,178 @@
+#include "particlestore.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cpu.h"
+#include "particlebudget.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#define HAVE_SSE_KERNELS
+#endif
+
+ParticleStore::TIntegrateFunction ParticleStore::m_pIntegrate = ParticleStore::IntegrateDispatch;
+
+ParticleStore::ParticleStore(int iCapacity, ParticleBudget* pBudget)
+	: m_iCapacity(iCapacity), m_iPaddedCapacity((iCapacity + 3) & ~3), m_iNumParticles(0),
+	  m_iFreeSlot(-1), m_pBudget(pBudget)
+{
+	assert(iCapacity >= 0 && iCapacity <= (int)m_ciSlotMask);
+
+	// Zero everything, so that the padding never holds anything odd
+	size_t uiSize = m_ciNumFields * m_iPaddedCapacity * sizeof(float);
+	void* pData;
+	if (posix_memalign(&pData, 16, uiSize) != 0)
+		assert(0);
+	memset(pData, 0, uiSize);
+	m_pData = (float*)pData;
+	for (int i = 0; i < m_ciNumFields; i++)
+		m_apField[i] = m_pData + i * m_iPaddedCapacity;
+	m_aiState = new int[m_iPaddedCapacity];
+	memset(m_aiState, 0, m_iPaddedCapacity * sizeof(int));
+
+	// Chain all handle table entries together
+	m_auiHandle = new THandle[m_iCapacity];
+	m_aSlot = new Slot[m_iCapacity];
+	for (int i = m_iCapacity - 1; i >= 0; i--) {
+		m_aSlot[i].m_iIndex = m_iFreeSlot;
+		m_aSlot[i].m_uiGeneration = 0;
+		m_iFreeSlot = i;
+	}
+}
+
+ParticleStore::~ParticleStore()
+{
+	Clear();
+	delete[] m_aSlot;
+	delete[] m_auiHandle;
+	delete[] m_aiState;
+	free(m_pData);
+}
+
+int
+ParticleStore::Add(THandle* pHandle)
+{
+	if (IsFull())
+		return -1;
+	if (m_pBudget != NULL && !m_pBudget->Acquire())
+		return -1;
+
+	int n = m_iNumParticles++;
+	for (int i = 0; i < m_ciNumFields; i++)
+		m_apField[i][n] = 0.0f;
+	m_aiState[n] = 0;
+
+	// Take the first free handle
+	int iSlot = m_iFreeSlot;
+	assert(iSlot >= 0);
+	m_iFreeSlot = m_aSlot[iSlot].m_iIndex;
+	m_aSlot[iSlot].m_iIndex = n;
+	m_auiHandle[n] = (m_aSlot[iSlot].m_uiGeneration << m_ciSlotBits) | iSlot;
+	if (pHandle != NULL)
+		*pHandle = m_auiHandle[n];
+	return n;
+}
+
+int
+ParticleStore::Lookup(THandle uiHandle) const
+{
+	int iSlot = uiHandle & m_ciSlotMask;
+	if (iSlot >= m_iCapacity || m_aSlot[iSlot].m_uiGeneration != (uiHandle >> m_ciSlotBits))
+		return -1;
+	return m_aSlot[iSlot].m_iIndex;
+}
+
+void
+ParticleStore::Clear()
+{
+	while (m_iNumParticles > 0)
+		Kill(m_iNumParticles - 1);
+}
+
+void
+ParticleStore::Kill(int n)
+{
+	assert(n >= 0 && n < m_iNumParticles);
+
+	// Free the handle; the new generation makes any copies of it stale
+	int iSlot = m_auiHandle[n] & m_ciSlotMask;
+	m_aSlot[iSlot].m_uiGeneration = (m_aSlot[iSlot].m_uiGeneration + 1) & m_ciGenerationMask;
+	m_aSlot[iSlot].m_iIndex = m_iFreeSlot;
+	m_iFreeSlot = iSlot;
+	if (m_pBudget != NULL)
+		m_pBudget->Release(1);
+
+	int iLast = --m_iNumParticles;
+	if (n == iLast)
+		return;
+	for (int i = 0; i < m_ciNumFields; i++)
+		m_apField[i][n] = m_apField[i][iLast];
+	m_aiState[n] = m_aiState[iLast];
+	m_auiHandle[n] = m_auiHandle[iLast];
+	m_aSlot[m_auiHandle[n] & m_ciSlotMask].m_iIndex = n;
+}
+
+void
+ParticleStore::IntegrateDispatch(ParticleStore& oStore)
+{
+	m_pIntegrate = CPU::HasSSE() ? IntegrateSSE : IntegrateScalar;
+	m_pIntegrate(oStore);
+}
+
+void
+ParticleStore::IntegrateScalar(ParticleStore& oStore)
+{
+	float* pX = oStore.GetX();
+	float* pY = oStore.GetY();
+	float* pZ = oStore.GetZ();
+	float* pSpeedX = oStore.GetSpeedX();
+	float* pSpeedY = oStore.GetSpeedY();
+	float* pSpeedZ = oStore.GetSpeedZ();
+	float* pGravity = oStore.GetGravity();
+	float* pLifetime = oStore.GetLifetime();
+	float* pDecay = oStore.GetDecay();
+	for (int n = 0; n < oStore.m_iNumParticles; n++) {
+		pX[n] += pSpeedX[n];
+		pY[n] += pSpeedY[n];
+		pZ[n] += pSpeedZ[n];
+		pLifetime[n] -= pDecay[n];
+		pSpeedY[n] += pGravity[n];
+	}
+}
+
+#ifdef HAVE_SSE_KERNELS
+__attribute__((target("sse"))) void
+ParticleStore::IntegrateSSE(ParticleStore& oStore)
+{
+	float* pX = oStore.GetX();
+	float* pY = oStore.GetY();
+	float* pZ = oStore.GetZ();
+	float* pSpeedX = oStore.GetSpeedX();
+	float* pSpeedY = oStore.GetSpeedY();
+	float* pSpeedZ = oStore.GetSpeedZ();
+	float* pGravity = oStore.GetGravity();
+	float* pLifetime = oStore.GetLifetime();
+	float* pDecay = oStore.GetDecay();
+
+	/*
+	 * The arrays are aligned and padded, so we can simply handle four
+	 * particles at a time; whatever is in the padding is never used.
+	 */
+	for (int n = 0; n < oStore.m_iNumParticles; n += 4) {
+		__m128 oSpeedY = _mm_load_ps(pSpeedY + n);
+		_mm_store_ps(pX + n, _mm_add_ps(_mm_load_ps(pX + n), _mm_load_ps(pSpeedX + n)));
+		_mm_store_ps(pY + n, _mm_add_ps(_mm_load_ps(pY + n), oSpeedY));
+		_mm_store_ps(pZ + n, _mm_add_ps(_mm_load_ps(pZ + n), _mm_load_ps(pSpeedZ + n)));
+		_mm_store_ps(pLifetime + n, _mm_sub_ps(_mm_load_ps(pLifetime + n), _mm_load_ps(pDecay + n)));
+		_mm_store_ps(pSpeedY + n, _mm_add_ps(oSpeedY, _mm_load_ps(pGravity + n)));
+	}
+}
+#else
+void
+ParticleStore::IntegrateSSE(ParticleStore& oStore)
+{
+	IntegrateScalar(oStore);
+}
+#endif /* HAVE_SSE_KERNELS */
+
+/* vim:set ts=2 sw=2: */
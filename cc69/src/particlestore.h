@@ -0,0 +1,201 @@
+#ifndef __PARTICLESTORE_H__
+#define __PARTICLESTORE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+class ParticleBudget;
+
+/*! \brief Contiguous storage for a fixed number of particles
+ *
+ *  Every particle property is kept in an array of its own, so that the
+ *  particles can be updated a few at a time using SIMD instructions. Live
+ *  particles always occupy the first GetNumParticles() entries; killing a
+ *  particle moves the last one in its place.
+ *
+ *  Arrays are padded to a multiple of four entries, so SIMD code may always
+ *  process particles in groups of four.
+ *
+ *  As indices change when particles die, every particle also has a handle
+ *  which remains the same during its life. Handles are kept in a table
+ *  whose unused entries form a free list, so neither adding nor killing a
+ *  particle allocates anything.
+ */
+class ParticleStore
+{
+public:
+	//! \brief Stable reference to a particle
+	typedef uint32_t THandle;
+
+	/*! \brief Constructs an empty store
+	 *  \param iCapacity Maximum number of particles
+	 *  \param pBudget Budget shared with other stores, if any
+	 */
+	ParticleStore(int iCapacity, ParticleBudget* pBudget = NULL);
+
+	//! \brief Destroys the store
+	~ParticleStore();
+
+	//! \brief Retrieve the maximum number of particles
+	int GetCapacity() const { return m_iCapacity; }
+
+	//! \brief Retrieve the number of live particles
+	int GetNumParticles() const { return m_iNumParticles; }
+
+	//! \brief Is there no room for another particle?
+	bool IsFull() const { return m_iNumParticles == m_iCapacity; }
+
+	//! \brief Retrieve the budget shared with other stores, NULL if none
+	ParticleBudget* GetBudget() const { return m_pBudget; }
+
+	/*! \brief Adds a particle
+	 *  \param pHandle If not NULL, receives the handle of the new particle
+	 *  \returns Index of the new particle, or -1 if the store or the budget
+	 *           is full
+	 *
+	 *  All properties of the new particle are zero.
+	 */
+	int Add(THandle* pHandle = NULL);
+
+	/*! \brief Removes a particle
+	 *  \param n Index of the particle to remove
+	 *
+	 *  The last particle is moved to index n.
+	 */
+	void Kill(int n);
+
+	//! \brief Removes all particles
+	void Clear();
+
+	//! \brief Retrieve the handle of a particle
+	THandle GetHandle(int n) const { return m_auiHandle[n]; }
+
+	/*! \brief Looks up a particle by handle
+	 *  \param uiHandle Handle to look up
+	 *  \returns Index of the particle, or -1 if it has died since
+	 *
+	 *  Handles are only guaranteed to be recognized as stale until their
+	 *  slot has been reused 256 times.
+	 */
+	int Lookup(THandle uiHandle) const;
+
+	/*! \brief Moves all particles a single step
+	 *
+	 *  Every particle's position is advanced by its speed, its lifetime is
+	 *  decreased by its decay and its vertical speed is increased by its
+	 *  gravity.
+	 */
+	void Integrate() { m_pIntegrate(*this); }
+
+	//! \brief Plain implementation of Integrate()
+	static void IntegrateScalar(ParticleStore& oStore);
+
+	/*! \brief SSE implementation of Integrate()
+	 *
+	 *  This must only be called if CPU::HasSSE() holds.
+	 */
+	static void IntegrateSSE(ParticleStore& oStore);
+
+	float* GetX() { return m_apField[m_ciX]; }
+	float* GetY() { return m_apField[m_ciY]; }
+	float* GetZ() { return m_apField[m_ciZ]; }
+	float* GetSpeedX() { return m_apField[m_ciSpeedX]; }
+	float* GetSpeedY() { return m_apField[m_ciSpeedY]; }
+	float* GetSpeedZ() { return m_apField[m_ciSpeedZ]; }
+	float* GetGravity() { return m_apField[m_ciGravity]; }
+	float* GetLifetime() { return m_apField[m_ciLifetime]; }
+	float* GetDecay() { return m_apField[m_ciDecay]; }
+	float* GetR() { return m_apField[m_ciR]; }
+	float* GetG() { return m_apField[m_ciG]; }
+	float* GetB() { return m_apField[m_ciB]; }
+	float* GetA() { return m_apField[m_ciA]; }
+	float* GetSize() { return m_apField[m_ciSize]; }
+
+	//! \brief Retrieve the per-particle state, for use by whoever owns the store
+	int* GetState() { return m_aiState; }
+
+private:
+	typedef void (*TIntegrateFunction)(ParticleStore& oStore);
+
+	//! \brief Selects the implementation to use and calls it
+	static void IntegrateDispatch(ParticleStore& oStore);
+
+	//! \brief Implementation of Integrate() in use
+	static TIntegrateFunction m_pIntegrate;
+
+	/*
+	 * Indices of the properties within m_apField.
+	 */
+	static const int m_ciX = 0;
+	static const int m_ciY = 1;
+	static const int m_ciZ = 2;
+	static const int m_ciSpeedX = 3;
+	static const int m_ciSpeedY = 4;
+	static const int m_ciSpeedZ = 5;
+	static const int m_ciGravity = 6;
+	static const int m_ciLifetime = 7;
+	static const int m_ciDecay = 8;
+	static const int m_ciR = 9;
+	static const int m_ciG = 10;
+	static const int m_ciB = 11;
+	static const int m_ciA = 12;
+	static const int m_ciSize = 13;
+	static const int m_ciNumFields = 14;
+
+	//! \brief Maximum number of particles
+	int m_iCapacity;
+
+	//! \brief Number of entries per array; this is a multiple of 4
+	int m_iPaddedCapacity;
+
+	//! \brief Number of live particles
+	int m_iNumParticles;
+
+	//! \brief Single 16-byte aligned allocation holding all properties
+	float* m_pData;
+
+	//! \brief Arrays of every property, pointing within m_pData
+	float* m_apField[m_ciNumFields];
+
+	//! \brief Per-particle state
+	int* m_aiState;
+
+	//! \brief Handle of every particle
+	THandle* m_auiHandle;
+
+	/*! \brief An entry of the handle table
+	 *
+	 *  Handles consist of the entry number and its generation, which is
+	 *  incremented whenever the entry is freed.
+	 */
+	struct Slot {
+		//! \brief Index of the particle, or the next free entry if unused
+		int m_iIndex;
+
+		//! \brief Generation of the entry
+		unsigned int m_uiGeneration;
+	};
+
+	//! \brief Handle table
+	Slot* m_aSlot;
+
+	//! \brief First unused entry of the handle table, -1 if none
+	int m_iFreeSlot;
+
+	//! \brief Budget to take particles from, if any
+	ParticleBudget* m_pBudget;
+
+	/*! \brief Number of handle bits used for the entry number
+	 *
+	 *  The remaining bits hold the generation.
+	 */
+	static const int m_ciSlotBits = 24;
+
+	//! \brief Mask selecting the entry number of a handle
+	static const THandle m_ciSlotMask = (1 << m_ciSlotBits) - 1;
+
+	//! \brief Mask selecting the generation, once shifted down
+	static const unsigned int m_ciGenerationMask = 0xff;
+};
+
+#endif /* __PARTICLESTORE_H__ */
@@ -0,0 +1,58 @@
+#ifndef __PARTICLESYSTEM_H__
+#define __PARTICLESYSTEM_H__
+
+#include "particleengine.h"
+
+/*! \brief Particle engine whose behaviour is composed at compile time
+ *
+ *  Every frame is handled in stages, each of which is supplied as a policy
+ *  class:
+ *
+ *  - INTEGRATOR::Integrate(ParticleStore&) moves all particles at once.
+ *  - FADE::Fade(ParticleStore&, int n) adjusts a single particle, i.e. its
+ *    color or alpha.
+ *  - LIFECYCLE::OnDeath(ParticleStore&, int n) is called for a particle
+ *    whose lifetime ran out and returns true if it was given a new life;
+ *    otherwise, the particle is removed.
+ *  - EMITTER::Emit(ParticleStore&) adds new particles as it sees fit.
+ *
+ *  The per-particle stages are called from a single loop and will normally
+ *  be inlined; none of them involve virtual calls. See particlepolicies.h
+ *  for the generic policies.
+ */
+template<class EMITTER, class INTEGRATOR, class FADE, class LIFECYCLE>
+class ParticleSystem : public ParticleEngine
+{
+public:
+	/*! \brief Constructs a new particle system
+	 *  \param iCount Number of particles to maintain
+	 *  \param oEmitter Emitter to use
+	 *  \param pBudget Budget shared with other engines, if any
+	 */
+	ParticleSystem(int iCount, const EMITTER& oEmitter = EMITTER(), ParticleBudget* pBudget = NULL)
+	 : ParticleEngine(iCount, pBudget), m_oEmitter(oEmitter)
+	{
+	}
+
+	//! \brief Initializes the particle system and emits the first particles
+	void Initialize();
+
+	//! \brief Evolves all particles to the next phase
+	void Evolve();
+
+	//! \brief Retrieve the emitter
+	EMITTER& GetEmitter() { return m_oEmitter; }
+
+	//! \brief Retrieve the fade policy
+	FADE& GetFade() { return m_oFade; }
+
+private:
+	EMITTER m_oEmitter;
+	INTEGRATOR m_oIntegrator;
+	FADE m_oFade;
+	LIFECYCLE m_oLifecycle;
+};
+
+#include "particlesystem.inl"
+
+#endif /* __PARTICLESYSTEM_H__ */
@@ -0,0 +1,29 @@
+template<class EMITTER, class INTEGRATOR, class FADE, class LIFECYCLE> void
+ParticleSystem<EMITTER, INTEGRATOR, FADE, LIFECYCLE>::Initialize()
+{
+	ParticleEngine::Initialize();
+	m_oEmitter.Emit(GetStore());
+}
+
+template<class EMITTER, class INTEGRATOR, class FADE, class LIFECYCLE> void
+ParticleSystem<EMITTER, INTEGRATOR, FADE, LIFECYCLE>::Evolve()
+{
+	ParticleStore& oStore = GetStore();
+	m_oIntegrator.Integrate(oStore);
+
+	const float* pLifetime = oStore.GetLifetime();
+	for (int n = 0; n < oStore.GetNumParticles(); /* nothing */) {
+		m_oFade.Fade(oStore, n);
+		if (pLifetime[n] > 0.0f || m_oLifecycle.OnDeath(oStore, n)) {
+			n++;
+			continue;
+		}
+
+		// This moves the last particle here, so look at this index again
+		oStore.Kill(n);
+	}
+
+	m_oEmitter.Emit(oStore);
+}
+
+/* vim:set ts=2 sw=2: */
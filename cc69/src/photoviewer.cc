@@ -2,6 +2,7 @@
 #include <GL/glu.h>
 #include <SDL/SDL.h>
 #include <assert.h>
+#include <algorithm>
 #include <err.h>
 #include "app.h"
 #include "events.h"
@@ -10,12 +11,13 @@
 #include "image.h"
 #include "photoviewer.h"
 #include "messagewindow.h"
+#include "spritebatch.h"
 
 PhotoViewer::PhotoViewer()
-	: m_iCurrentImage(0), m_iPreviousImage(0), m_fZoom(0.0f), m_iDirection(1),
-		m_iSlideShowInterval(0), m_iSlideShowCounter(0), m_iAnimation(0),
-		m_iAnimationEffect(0), m_poMessageWindow(NULL),
-		m_bMessageWindowVisible(false), m_bLeaving(false)
+	: m_bLeaving(false), m_bDirty(true), m_fZoom(0.0f),
+		m_iCurrentImage(0), m_iPreviousImage(0), m_iDisplayedImage(-1), m_iDirection(1),
+		m_iAnimation(0), m_iAnimationEffect(0),
+		m_bMessageWindowVisible(false), m_poMessageWindow(NULL)
 {
 }
 
@@ -30,12 +32,13 @@ PhotoViewer::Init()
 	float fMessageWindowWidth = g_oApp.GetScreenWidth() * 0.25f;
 	float fMessageWindowHeight = g_oApp.GetScreenHeight() / 10.0f;
 	m_poMessageWindow = new MessageWindow(fMessageWindowWidth, fMessageWindowHeight, 10.0f);
-	m_poMessageWindow->Create();
 	m_poMessageWindow->SetPosition(
 		(g_oApp.GetScreenWidth() - fMessageWindowWidth) / 2.0f,
 		g_oApp.GetScreenHeight() - fMessageWindowHeight * 1.5f
 	);
 	g_oApp.GetEvents().SetLEDs(Events::m_ciLedOn, Events::m_ciLedOn);
+	m_bLeaving = false;
+	m_bDirty = true;
 }
 
 void
@@ -44,28 +47,21 @@ PhotoViewer::Cleanup()
 }
 
 void
-PhotoViewer::Render()
+PhotoViewer::Render(float fAlpha)
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glLoadIdentity();
+	m_bDirty = false;
 
 	/*
-	 * If we are animating, fetch the previous image as well. This is
-	 * set by Next() when transitioning, so we are certain that this
-	 * image is not corrupt (it has already been shown)
+	 * Fetch the current image; this needs to skip over any corrupt images. We
+	 * never wait for the decoder here, as that would freeze the display.
 	 */
-	Image* pPreviousImage = NULL;
-	if (m_iAnimation && m_iPreviousImage >= 0) {
-		pPreviousImage = g_oApp.GetImageLibrary().GetLocked(m_iPreviousImage);
-		assert(!pPreviousImage->IsCorrupt());
-	}
-
-	// Fetch the current image; this needs to skip over any corrupt images
 	Image* pImage = NULL;
 	int iOriginalImage = m_iCurrentImage;
 	while(true) {
-		pImage = g_oApp.GetImageLibrary().GetLocked(m_iCurrentImage);
-		if (!pImage->IsCorrupt())
+		pImage = g_oApp.GetImageLibrary().TryGetLocked(m_iCurrentImage);
+		if (pImage == NULL || !pImage->IsCorrupt())
 			break;
 
 		// Oops, this photo was corrupted!
@@ -77,46 +73,78 @@ PhotoViewer::Render()
 		}
 	}
 
-	// If we have a previous image, we need to do an animation
+	if (pImage != NULL && !pImage->IsResident()) {
+		/*
+		 * The image is decoded but not completely uploaded; drawing it now
+		 * would upload the remainder at once and stall this frame. Have the
+		 * scheduler upload it first instead.
+		 */
+		g_oApp.GetImageLibrary().GetUploadScheduler().Queue(pImage, true);
+		pImage->Unlock();
+		pImage = NULL;
+	}
+
+	if (pImage == NULL) {
+		/*
+		 * The image is still being decoded or uploaded; keep showing whatever
+		 * we showed last and hold off any animation until the new image is
+		 * ready.
+		 */
+		RenderPlaceholder();
+		return;
+	}
+
+	/*
+	 * If we are animating, fetch the previous image as well. This is
+	 * set by Next() when transitioning, so we are certain that this
+	 * image is not corrupt (it has already been shown). If it is not
+	 * available or resident anymore, we'll just skip the animation.
+	 */
+	Image* pPreviousImage = NULL;
+	if (m_iAnimation && m_iPreviousImage >= 0) {
+		pPreviousImage = g_oApp.GetImageLibrary().TryGetLocked(m_iPreviousImage, false);
+		if (pPreviousImage != NULL && !pPreviousImage->IsResident()) {
+			pPreviousImage->Unlock();
+			pPreviousImage = NULL;
+		}
+		if (pPreviousImage == NULL)
+			m_iAnimation = 0;
+		else
+			assert(!pPreviousImage->IsCorrupt());
+	}
+	m_iDisplayedImage = m_iCurrentImage;
+
+	/*
+	 * If we have a previous image, we need to do an animation; this also
+	 * determines where and how the new image is drawn.
+	 */
+	float fOffset = 0.0f;
+	float fDepth = 0.0f;
+	SpriteBatch::Blend oBlend;
+	uint32_t uiColor = SpriteBatch::m_ciWhite;
 	if (pPreviousImage != NULL) {
-		glLoadIdentity();
+		// Animations advance in Update(); move along with the part of the step that passed
+		float fProgress = m_oAnimation.GetProgress(fAlpha / g_oApp.GetDesiredFPS());
+		float fSlide = fProgress * g_oApp.GetScreenWidth();
 		switch(m_iAnimation) {
 			case 1: // horizontal left slide in
-				glTranslatef(m_fAnimationCounter, 0.0f, 0.0f);
-				RenderImage(pPreviousImage);
-
-				glLoadIdentity();
-				glTranslatef(m_fAnimationCounter - g_oApp.GetScreenWidth(), 0.0f, 0.0f);
-				m_fAnimationCounter += 25.0f;
-				if (m_fAnimationCounter >= g_oApp.GetScreenWidth())
-					m_iAnimation = 0;
+				RenderImage(pPreviousImage, fSlide, 0.0f, oBlend, uiColor);
+				fOffset = fSlide - g_oApp.GetScreenWidth();
 				break;
 			case 2: // horizontal right slide in
-				glTranslatef(-m_fAnimationCounter, 0.0f, 0.0f);
-				RenderImage(pPreviousImage);
-
-				glLoadIdentity();
-				glTranslatef(g_oApp.GetScreenWidth() - m_fAnimationCounter, 0.0f, 0.0f);
-				m_fAnimationCounter += 25;
-				if (m_fAnimationCounter >= g_oApp.GetScreenWidth())
-					m_iAnimation = 0;
+				RenderImage(pPreviousImage, -fSlide, 0.0f, oBlend, uiColor);
+				fOffset = g_oApp.GetScreenWidth() - fSlide;
 				break;
 			case 3: { // blend
 				/* Fade from here... */
-				glEnable(GL_BLEND);
-				glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_ONE);
+				oBlend = SpriteBatch::Blend(GL_ONE_MINUS_SRC_ALPHA, GL_ONE);
+				RenderImage(pPreviousImage, 0.0f, 0.0f, oBlend, SpriteBatch::MakeColor(1.0f, 1.0f, 1.0f, fProgress));
 
-				glColor4f(1.0f, 1.0f, 1.0f, m_fAnimationCounter);
-				RenderImage(pPreviousImage);
 				/* ... to the new image */
-				glColor4f(1.0f, 1.0f, 1.0f, 1.0f - m_fAnimationCounter);
+				uiColor = SpriteBatch::MakeColor(1.0f, 1.0f, 1.0f, 1.0f - fProgress);
 
 				/* Force the new image on top of the other */
-				glTranslatef(0.0f, 0.0f, 0.1f);
-
-				m_fAnimationCounter += 0.08;
-				if (m_fAnimationCounter >= 1.0f)
-					m_iAnimation = 0;
+				fDepth = 0.1f;
 				break;
 			}
 		}
@@ -130,33 +158,51 @@ PhotoViewer::Render()
 	m_poMessageWindow->Update(sImageFile);
 
 	// Render the new image
-	RenderImage(pImage);
+	RenderImage(pImage, fOffset, fDepth, oBlend, uiColor);
 
-	// Done with the images
+	// Show the message window, if necessary
+	if (m_bMessageWindowVisible)
+		m_poMessageWindow->Render();
+
+	// Render
+	g_oApp.GetSpriteBatch().Flush();
+
+	// Done with the images; their textures must stay around until the batch is drawn
 	pImage->Unlock();
 	if (pPreviousImage != NULL)
 		pPreviousImage->Unlock();
+}
 
-	glDisable(GL_BLEND);
+void
+PhotoViewer::RenderPlaceholder()
+{
+	Image* pImage = NULL;
+	if (m_iDisplayedImage >= 0) {
+		pImage = g_oApp.GetImageLibrary().TryGetLocked(m_iDisplayedImage, false);
+		if (pImage != NULL && pImage->IsResident())
+			RenderImage(pImage, 0.0f, 0.0f, SpriteBatch::Blend(), SpriteBatch::m_ciWhite);
+	}
 
 	// Show the message window, if necessary
 	if (m_bMessageWindowVisible)
 		m_poMessageWindow->Render();
 
-	// Render
-	SDL_GL_SwapBuffers();
+	g_oApp.GetSpriteBatch().Flush();
+
+	// Keep the image locked until its texture is drawn
+	if (pImage != NULL)
+		pImage->Unlock();
 }
 
 void
-PhotoViewer::RenderImage(Image* pImage)
+PhotoViewer::RenderImage(Image* pImage, float fOffset, float fDepth, const SpriteBatch::Blend& oBlend, uint32_t uiColor)
 {
 	// Calculate the <left,top> - <right, bottom> points on screen
-	float fTop, fLeft, fRight, fBottom, fDepth;
+	float fTop, fLeft, fRight, fBottom;
 	fTop    = 0;
 	fLeft   = 0;
 	fRight  = pImage->GetWidth();
 	fBottom = pImage->GetHeight();
-	fDepth  = 0;
 
 	// If the photo doesn't fit, make it
 	if (fRight >= g_oApp.GetScreenWidth() || fBottom >= g_oApp.GetScreenHeight()) {
@@ -199,8 +245,8 @@ PhotoViewer::RenderImage(Image* pImage)
 		}
 	}
 
-	// Scaling is done; see if we need to center the photo
-	float fWidthLeft = (g_oApp.GetScreenWidth() - (fRight - fLeft)) / 2.0f;
+	// Scaling is done; see if we need to center the photo (and move it along)
+	float fWidthLeft = (g_oApp.GetScreenWidth() - (fRight - fLeft)) / 2.0f + fOffset;
 	float fHeightLeft = (g_oApp.GetScreenWidth() - (fBottom - fTop)) / 2.0f;
 	fLeft += fWidthLeft; fRight += fWidthLeft;
 	fTop += fHeightLeft; fBottom += fHeightLeft;
@@ -216,15 +262,9 @@ PhotoViewer::RenderImage(Image* pImage)
 		fBottom = fTop;
 
 	// Draw the image
-	float fTexHeight = pImage->GetNormalizedHeight();
-	float fTexWidth  = pImage->GetNormalizedWidth();
-	glBindTexture(GL_TEXTURE_2D, pImage->GetTextureID());
-	glBegin(GL_QUADS);
-	glTexCoord2f(     0.0f,       0.0f); glVertex3f( fLeft,  fTop,    fDepth);
-	glTexCoord2f(fTexWidth,       0.0f); glVertex3f( fRight, fTop,    fDepth);
-	glTexCoord2f(fTexWidth, fTexHeight); glVertex3f( fRight, fBottom, fDepth);
-	glTexCoord2f(     0.0f, fTexHeight); glVertex3f( fLeft,  fBottom, fDepth);
-	glEnd();
+	g_oApp.GetSpriteBatch().AddRect(pImage->GetTextureID(), oBlend,
+	 fLeft, fTop, fRight, fBottom, fDepth,
+	 0.0f, 0.0f, pImage->GetNormalizedWidth(), pImage->GetNormalizedHeight(), uiColor);
 }
 
 void
@@ -238,29 +278,30 @@ PhotoViewer::HandleEvents()
 	} else if (oEvents.CheckAndResetLeft()) {
 		m_iAnimationEffect = 1;
 		Next(-1);
-		if (m_iSlideShowInterval != 0) {
-			m_iSlideShowInterval = 0;
+		if (m_oSlideShowTimer.IsRunning()) {
+			m_oSlideShowTimer.Stop();
 			g_oApp.GetEvents().SetLEDs(Events::m_ciLedOn, Events::m_ciLedOn);
 		}
 	} else if (oEvents.CheckAndResetRight()) {
 		m_iAnimationEffect = 1;
 		Next(1);
-		if (m_iSlideShowInterval != 0) {
-			m_iSlideShowInterval = 0;
+		if (m_oSlideShowTimer.IsRunning()) {
+			m_oSlideShowTimer.Stop();
 			g_oApp.GetEvents().SetLEDs(Events::m_ciLedOn, Events::m_ciLedOn);
 		}
 	} else if (oEvents.CheckAndResetMinus()) {
 		m_fZoom -= 5.0f;
+		m_bDirty = true;
 	} else if (oEvents.CheckAndResetPlus()) {
 		m_fZoom += 5.0f;
+		m_bDirty = true;
 	} else if (oEvents.CheckAndResetStop()) {
-		if (m_iSlideShowInterval == 0)
+		if (!m_oSlideShowTimer.IsRunning())
 			m_bLeaving = true;
-		m_iSlideShowInterval = 0;
+		m_oSlideShowTimer.Stop();
 		g_oApp.GetEvents().SetLEDs(Events::m_ciLedOn, Events::m_ciLedOn);
 	} else if (oEvents.CheckAndResetStart()) {
-		m_iSlideShowInterval = g_oApp.GetDesiredFPS(); /* 1 sec per image */
-		m_iSlideShowCounter = m_iSlideShowInterval;
+		SlideShow(1.0f);
 		m_iAnimationEffect = 2;
 		g_oApp.GetEvents().SetLEDs(Events::m_ciLedOn, Events::m_ciLedOn);
 	}
@@ -276,7 +317,10 @@ PhotoViewer::Next(int iDirection, bool bUpdatePrev /* = true */)
 			case 1: m_iAnimation = (iDirection < 0) ? 1 : 2; break;
 			case 2: m_iAnimation = 3; break;
 		}
-		m_fAnimationCounter = 0;
+		if (m_iAnimation == 3)
+			m_oAnimation.Start(m_ciBlendTime / 1000.0f);
+		else if (m_iAnimation != 0)
+			m_oAnimation.Start(m_ciSlideTime / 1000.0f, Easing::EaseInOut);
 	}
 	switch(iDirection) {
 		case -1:
@@ -292,34 +336,47 @@ PhotoViewer::Next(int iDirection, bool bUpdatePrev /* = true */)
 			assert(0);
 	}
 	m_iDirection = iDirection;
+	m_bDirty = true;
 }
 
 void
-PhotoViewer::Run()
+PhotoViewer::Update(float fStep)
 {
-	m_bLeaving = false;
-	while(!m_bLeaving) {
-		HandleEvents();
-		Render();
-		SDL_Delay(1000 / g_oApp.GetDesiredFPS());
-
-		// Handle the slideshow, but only if there is no animation
-		if (m_iSlideShowInterval > 0 && m_iAnimation == 0) {
-			// Time to show the next image?
-			if (m_iSlideShowCounter-- <= 0) {
-				// Yes; do that and re-arm
-				Next(1);
-				m_iSlideShowCounter = m_iSlideShowInterval;
-			}
-		}
+	HandleEvents();
+
+	// Animations hold off until the new image is on screen
+	if (m_iAnimation != 0 && m_iDisplayedImage == m_iCurrentImage) {
+		m_oAnimation.Advance(fStep);
+		if (!m_oAnimation.IsRunning())
+			m_iAnimation = 0;
 	}
+
+	// Handle the slideshow, but only if there is no animation or pending image; the timer re-arms itself
+	if (m_iAnimation == 0 && m_iDisplayedImage == m_iCurrentImage && m_oSlideShowTimer.Advance(fStep) > 0)
+		Next(1);
+}
+
+bool
+PhotoViewer::IsDirty()
+{
+	// Until the current image is shown, Render() must keep trying
+	return m_bDirty || m_iAnimation != 0 || m_iDisplayedImage != m_iCurrentImage;
+}
+
+bool
+PhotoViewer::IsIdle()
+{
+	if (m_iAnimation != 0 || m_oSlideShowTimer.IsRunning() || m_iDisplayedImage != m_iCurrentImage)
+		return false;
+
+	// Decoded images keep being uploaded in the background
+	return g_oApp.GetImageLibrary().GetUploadScheduler().IsEmpty();
 }
 
 void
-PhotoViewer::SlideShow(int iInterval)
+PhotoViewer::SlideShow(float fInterval)
 {
-	m_iSlideShowInterval = iInterval;
-	m_iSlideShowCounter = iInterval;
+	m_oSlideShowTimer.Start(fInterval);
 }
 
 /* vim:set ts=2 sw=2: */
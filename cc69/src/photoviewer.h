@@ -1,7 +1,10 @@
 #ifndef __PHOTOVIEWER_H__
 #define __PHOTOVIEWER_H__
 
+#include <stdint.h>
+#include "animation.h"
 #include "runnable.h"
+#include "spritebatch.h"
 
 class MessageWindow;
 
@@ -13,23 +16,40 @@ public:
 
 	virtual void Init();
 	virtual void Cleanup();
-	virtual void Run();
+	virtual void Update(float fStep);
+	virtual void Render(float fAlpha);
+	virtual bool IsFinished() { return m_bLeaving; }
+	virtual bool IsDirty();
+	virtual bool IsIdle();
 
 protected:
-	void Render();
-	void RenderImage(Image* pImage);
+	/*! \brief Renders an image
+	 *  \param pImage Image to render
+	 *  \param fOffset Horizontal offset from the centered position
+	 *  \param fDepth Depth to render at
+	 *  \param oBlend Blending to use
+	 *  \param uiColor Color to modulate the image with
+	 */
+	void RenderImage(Image* pImage, float fOffset, float fDepth, const SpriteBatch::Blend& oBlend, uint32_t uiColor);
+	void RenderPlaceholder();
 	void HandleEvents();
 	void Next(int iDirection, bool bUpdatePrev = true);
 
-	void SlideShow(int iInterval);
+	/*! \brief Starts a slideshow
+	 *  \param fInterval Time each image is shown, in seconds
+	 */
+	void SlideShow(float fInterval);
 
 private:
-	int m_iSlideShowInterval;
-	int m_iSlideShowCounter;
+	//! \brief Advances the slideshow, if running
+	Timer m_oSlideShowTimer;
 
 	//! \brief Are we leaving yet?
 	bool m_bLeaving;
 
+	//! \brief Has the zoom factor or image changed since the last Render()?
+	bool m_bDirty;
+
 	//! \brief Zoom factor
 	float m_fZoom;
 
@@ -39,14 +59,23 @@ private:
 	//! \brief Prevous image being viewed
 	int m_iPreviousImage;
 
+	//! \brief Image last shown on screen, -1 if none yet
+	int m_iDisplayedImage;
+
 	//! \brief Current direction
 	int m_iDirection;
 
 	//! \brief Animation in use
 	int m_iAnimation;
 
-	//! \brief Animation counter
-	float m_fAnimationCounter;
+	//! \brief Progress of the animation in use
+	Animation m_oAnimation;
+
+	//! \brief Duration of the slide animations, in milliseconds
+	static const int m_ciSlideTime = 650;
+
+	//! \brief Duration of the blend animation, in milliseconds
+	static const int m_ciBlendTime = 200;
 
 	//! \brief Which animation effect to use
 	int m_iAnimationEffect;
@@ -0,0 +1,145 @@
+#include "pixelbufferpool.h"
+#include <assert.h>
+#include <iostream>
+#include "app.h"
+#include "glextensions.h"
+
+PixelBufferPool::TBufferVector PixelBufferPool::m_oBuffers;
+PixelBufferPool::TBufferVector PixelBufferPool::m_oAvailable;
+PixelBufferPool::TBufferVector PixelBufferPool::m_oDeferred;
+size_t PixelBufferPool::m_uiBufferSize = 0;
+unsigned int PixelBufferPool::m_uiNumHits = 0;
+unsigned int PixelBufferPool::m_uiNumMisses = 0;
+boost::mutex PixelBufferPool::m_oLock;
+boost::thread::id PixelBufferPool::m_oMainThread;
+
+void
+PixelBufferPool::Init(int iNumBuffers, size_t uiBufferSize)
+{
+	if (!GLExtensions::HasPixelBufferObjects())
+		return;
+
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	assert(m_oBuffers.empty());
+	m_oMainThread = boost::this_thread::get_id();
+	m_uiBufferSize = uiBufferSize;
+	for (int n = 0; n < iNumBuffers; n++) {
+		Buffer* pBuffer = new Buffer;
+		GLExtensions::GenBuffers(1, &pBuffer->m_iBuffer);
+		GLExtensions::BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, pBuffer->m_iBuffer);
+		GLExtensions::BufferData(GL_PIXEL_UNPACK_BUFFER_ARB, m_uiBufferSize, NULL, GL_STREAM_DRAW_ARB);
+		pBuffer->m_pData = GLExtensions::MapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
+		if (pBuffer->m_pData == NULL) {
+			// Out of mappable memory; make do with what we have
+			GLExtensions::DeleteBuffers(1, &pBuffer->m_iBuffer);
+			delete pBuffer;
+			break;
+		}
+		m_oBuffers.push_back(pBuffer);
+		m_oAvailable.push_back(pBuffer);
+	}
+	GLExtensions::BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+
+	if (g_oApp.IsVerbose())
+		std::cerr << "PixelBufferPool: " << m_oBuffers.size() << " buffers of " << m_uiBufferSize / 1024 << "KB\n";
+}
+
+void
+PixelBufferPool::Cleanup()
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	for (TBufferVector::iterator it = m_oBuffers.begin(); it != m_oBuffers.end(); it++) {
+		Buffer* pBuffer = *it;
+		if (pBuffer->m_pData != NULL) {
+			GLExtensions::BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, pBuffer->m_iBuffer);
+			GLExtensions::UnmapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB);
+		}
+		GLExtensions::DeleteBuffers(1, &pBuffer->m_iBuffer);
+		delete pBuffer;
+	}
+	if (!m_oBuffers.empty())
+		GLExtensions::BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+	m_oBuffers.clear();
+	m_oAvailable.clear();
+	m_oDeferred.clear();
+
+	if (g_oApp.IsVerbose())
+		std::cerr << "PixelBufferPool: " << m_uiNumHits << " streamed uploads, " << m_uiNumMisses << " fallbacks\n";
+}
+
+PixelBufferPool::Buffer*
+PixelBufferPool::Acquire(size_t uiSize)
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	if (uiSize > m_uiBufferSize || m_oAvailable.empty()) {
+		m_uiNumMisses++;
+		return NULL;
+	}
+
+	m_uiNumHits++;
+	Buffer* pBuffer = m_oAvailable.back();
+	m_oAvailable.pop_back();
+	return pBuffer;
+}
+
+void
+PixelBufferPool::Bind(Buffer* pBuffer)
+{
+	assert(boost::this_thread::get_id() == m_oMainThread);
+
+	GLExtensions::BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, pBuffer->m_iBuffer);
+	if (pBuffer->m_pData != NULL) {
+		GLExtensions::UnmapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB);
+		pBuffer->m_pData = NULL;
+	}
+}
+
+void
+PixelBufferPool::Unbind()
+{
+	GLExtensions::BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+}
+
+void
+PixelBufferPool::Release(Buffer* pBuffer)
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	if (pBuffer->m_pData != NULL)
+		m_oAvailable.push_back(pBuffer);
+	else if (boost::this_thread::get_id() == m_oMainThread)
+		Remap(pBuffer);
+	else
+		m_oDeferred.push_back(pBuffer);
+}
+
+void
+PixelBufferPool::Replenish()
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	for (TBufferVector::iterator it = m_oDeferred.begin(); it != m_oDeferred.end(); it++)
+		Remap(*it);
+	m_oDeferred.clear();
+}
+
+void
+PixelBufferPool::Remap(Buffer* pBuffer)
+{
+	assert(boost::this_thread::get_id() == m_oMainThread);
+	assert(pBuffer->m_pData == NULL);
+
+	/*
+	 * The buffer may still be in use by a pending upload; discarding its
+	 * storage first lets the implementation hand us fresh memory rather than
+	 * waiting for that upload to complete.
+	 */
+	GLExtensions::BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, pBuffer->m_iBuffer);
+	GLExtensions::BufferData(GL_PIXEL_UNPACK_BUFFER_ARB, m_uiBufferSize, NULL, GL_STREAM_DRAW_ARB);
+	pBuffer->m_pData = GLExtensions::MapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
+	GLExtensions::BindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+
+	// If it cannot be mapped anymore, just leave it for Cleanup() to destroy
+	if (pBuffer->m_pData != NULL)
+		m_oAvailable.push_back(pBuffer);
+}
+
+/* vim:set ts=2 sw=2: */
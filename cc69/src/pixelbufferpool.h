@@ -0,0 +1,123 @@
+#ifndef __PIXELBUFFERPOOL_H__
+#define __PIXELBUFFERPOOL_H__
+
+#include <GL/gl.h>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+/*! \brief Pool of mapped pixel buffer objects
+ *
+ *  Texture data is normally converted into system memory and copied by
+ *  glTexImage2D() once the main thread needs the texture, which stalls the
+ *  main thread for the duration of the copy. Instead, the pool hands out
+ *  pixel unpack buffers which are already mapped; any thread can convert
+ *  image data directly into them, after which the main thread only has to
+ *  unmap the buffer and start the upload, which the OpenGL implementation
+ *  may perform asynchronously.
+ *
+ *  Mapping and unmapping must be done by the main thread: buffers are mapped
+ *  upon creation and mapped again when they are released after the upload,
+ *  so anything in the pool is ready to be written.
+ */
+class PixelBufferPool
+{
+public:
+	//! \brief A pixel buffer handed out by the pool
+	class Buffer
+	{
+	public:
+		//! \brief Retrieve the mapped buffer contents
+		void* GetData() const { return m_pData; }
+
+	private:
+		friend class PixelBufferPool;
+
+		//! \brief OpenGL buffer object
+		GLuint m_iBuffer;
+
+		//! \brief Mapped buffer contents, or NULL if unmapped
+		void* m_pData;
+	};
+
+	/*! \brief Creates the pool
+	 *  \param iNumBuffers Number of buffers to create
+	 *  \param uiBufferSize Size of every buffer, in bytes
+	 *
+	 *  This must be called by the main thread once OpenGL is initialized. If
+	 *  pixel buffer objects are unsupported, the pool will remain empty.
+	 */
+	static void Init(int iNumBuffers, size_t uiBufferSize);
+
+	//! \brief Destroys all buffers; must be called by the main thread
+	static void Cleanup();
+
+	/*! \brief Acquires a mapped buffer
+	 *  \param uiSize Number of bytes required
+	 *  \returns Buffer to use, or NULL if none is available
+	 *
+	 *  This may be called from any thread; callers must fall back to system
+	 *  memory if no buffer is available.
+	 */
+	static Buffer* Acquire(size_t uiSize);
+
+	/*! \brief Binds a buffer as the pixel unpack buffer
+	 *
+	 *  The buffer is unmapped on the first call; texture uploads will use its
+	 *  contents until Unbind() is called. The buffer stays unmapped until it
+	 *  is released. This must be called by the main thread.
+	 */
+	static void Bind(Buffer* pBuffer);
+
+	//! \brief Restores client memory texture uploads
+	static void Unbind();
+
+	/*! \brief Returns a buffer to the pool
+	 *
+	 *  This may be called from any thread; buffers that were unmapped by
+	 *  Bind() are mapped again by the main thread, which is deferred until
+	 *  Replenish() if we are called from another thread.
+	 */
+	static void Release(Buffer* pBuffer);
+
+	/*! \brief Maps buffers which were released by other threads
+	 *
+	 *  This must be called by the main thread.
+	 */
+	static void Replenish();
+
+private:
+	typedef std::vector<Buffer*> TBufferVector;
+
+	//! \brief All buffers created
+	static TBufferVector m_oBuffers;
+
+	//! \brief Mapped buffers ready to be acquired
+	static TBufferVector m_oAvailable;
+
+	//! \brief Unmapped buffers released by threads other than the main thread
+	static TBufferVector m_oDeferred;
+
+	//! \brief Size of every buffer, in bytes
+	static size_t m_uiBufferSize;
+
+	//! \brief Number of successful Acquire() calls
+	static unsigned int m_uiNumHits;
+
+	//! \brief Number of Acquire() calls that had to fall back
+	static unsigned int m_uiNumMisses;
+
+	//! \brief Lock protecting the pool
+	static boost::mutex m_oLock;
+
+	//! \brief Thread performing all OpenGL interactions
+	static boost::thread::id m_oMainThread;
+
+	/*! \brief Maps a buffer again and makes it available
+	 *
+	 *  This must be called by the main thread with m_oLock held.
+	 */
+	static void Remap(Buffer* pBuffer);
+};
+
+#endif /* __PIXELBUFFERPOOL_H__ */
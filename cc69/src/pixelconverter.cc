@@ -0,0 +1,68 @@
+#include "pixelconverter.h"
+#include "cpu.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <tmmintrin.h>
+#define HAVE_SSSE3_KERNELS
+#endif
+
+boost::once_flag PixelConverter::m_oSelectOnce = BOOST_ONCE_INIT;
+PixelConverter::TExpandFunction PixelConverter::m_pExpandRGBToRGBA = NULL;
+
+void
+PixelConverter::Select()
+{
+	m_pExpandRGBToRGBA = CPU::HasSSSE3() ? ExpandRGBToRGBASSSE3 : ExpandRGBToRGBAScalar;
+}
+
+void
+PixelConverter::ExpandRGBToRGBAScalar(const uint8_t* pSource, uint32_t* pDest, int iNumPixels)
+{
+	for (int n = 0; n < iNumPixels; n++) {
+		uint32_t value = *pSource++;
+		value |= *pSource++ << 8;
+		value |= *pSource++ << 16;
+		*pDest++ = value | 0xff000000 /* alpha */;
+	}
+}
+
+#ifdef HAVE_SSSE3_KERNELS
+__attribute__((target("ssse3"))) void
+PixelConverter::ExpandRGBToRGBASSSE3(const uint8_t* pSource, uint32_t* pDest, int iNumPixels)
+{
+	/*
+	 * Every iteration converts 16 pixels: the 48 source bytes are split in 4
+	 * groups of 12 bytes, each of which is spread over 16 bytes using pshufb
+	 * after which the alpha value is or-ed in.
+	 */
+	const __m128i oShuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i oAlpha = _mm_set1_epi32(0xff000000);
+	int n = 0;
+	for (/* nothing */; n + 16 <= iNumPixels; n += 16) {
+		__m128i oIn0 = _mm_loadu_si128((const __m128i*)(pSource +  0));
+		__m128i oIn1 = _mm_loadu_si128((const __m128i*)(pSource + 16));
+		__m128i oIn2 = _mm_loadu_si128((const __m128i*)(pSource + 32));
+		__m128i oOut0 = _mm_shuffle_epi8(oIn0, oShuffle);
+		__m128i oOut1 = _mm_shuffle_epi8(_mm_alignr_epi8(oIn1, oIn0, 12), oShuffle);
+		__m128i oOut2 = _mm_shuffle_epi8(_mm_alignr_epi8(oIn2, oIn1, 8), oShuffle);
+		__m128i oOut3 = _mm_shuffle_epi8(_mm_srli_si128(oIn2, 4), oShuffle);
+		_mm_storeu_si128((__m128i*)(pDest +  0), _mm_or_si128(oOut0, oAlpha));
+		_mm_storeu_si128((__m128i*)(pDest +  4), _mm_or_si128(oOut1, oAlpha));
+		_mm_storeu_si128((__m128i*)(pDest +  8), _mm_or_si128(oOut2, oAlpha));
+		_mm_storeu_si128((__m128i*)(pDest + 12), _mm_or_si128(oOut3, oAlpha));
+		pSource += 48;
+		pDest += 16;
+	}
+
+	// Convert whatever is left the slow way
+	ExpandRGBToRGBAScalar(pSource, pDest, iNumPixels - n);
+}
+#else
+void
+PixelConverter::ExpandRGBToRGBASSSE3(const uint8_t* pSource, uint32_t* pDest, int iNumPixels)
+{
+	ExpandRGBToRGBAScalar(pSource, pDest, iNumPixels);
+}
+#endif /* HAVE_SSSE3_KERNELS */
+
+/* vim:set ts=2 sw=2: */
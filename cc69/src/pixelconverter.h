@@ -0,0 +1,54 @@
+#ifndef __PIXELCONVERTER_H__
+#define __PIXELCONVERTER_H__
+
+#include <stdint.h>
+#include <boost/thread/once.hpp>
+
+/*! \brief Converts pixel data between formats
+ *
+ *  The conversions are implemented using SIMD instructions where the CPU
+ *  supports them; which implementation is used is decided at runtime.
+ */
+class PixelConverter
+{
+public:
+	/*! \brief Expands 24-bit pixels to 32-bit pixels
+	 *  \param pSource Source pixels, 3 bytes each
+	 *  \param pDest Destination pixels
+	 *  \param iNumPixels Number of pixels to convert
+	 *
+	 *  The byte order of the color components is retained; the alpha
+	 *  channel is added as the most significant byte and fully opaque.
+	 */
+	static void ExpandRGBToRGBA(const uint8_t* pSource, uint32_t* pDest, int iNumPixels) {
+		boost::call_once(&PixelConverter::Select, m_oSelectOnce);
+		m_pExpandRGBToRGBA(pSource, pDest, iNumPixels);
+	}
+
+	//! \brief Plain implementation of ExpandRGBToRGBA()
+	static void ExpandRGBToRGBAScalar(const uint8_t* pSource, uint32_t* pDest, int iNumPixels);
+
+	/*! \brief SSSE3 implementation of ExpandRGBToRGBA()
+	 *
+	 *  This must only be called if CPU::HasSSSE3() holds.
+	 */
+	static void ExpandRGBToRGBASSSE3(const uint8_t* pSource, uint32_t* pDest, int iNumPixels);
+
+private:
+	typedef void (*TExpandFunction)(const uint8_t* pSource, uint32_t* pDest, int iNumPixels);
+
+	/*! \brief Selects the implementations to use
+	 *
+	 *  Decode workers convert images concurrently, so this is only called
+	 *  through m_oSelectOnce.
+	 */
+	static void Select();
+
+	//! \brief Ensures the implementations are selected exactly once
+	static boost::once_flag m_oSelectOnce;
+
+	//! \brief Implementation of ExpandRGBToRGBA() in use
+	static TExpandFunction m_pExpandRGBToRGBA;
+};
+
+#endif /* __PIXELCONVERTER_H__ */
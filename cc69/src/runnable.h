@@ -3,7 +3,10 @@
 
 /*! \brief Runnable interface
  *
- *  This is used as an interface to the subapplications.
+ *  This is used as an interface to the subapplications. They do not run a
+ *  loop of their own; the FrameScheduler calls Update() at a fixed rate and
+ *  Render() whenever a frame is to be drawn and IsDirty() holds, until
+ *  IsFinished() holds.
  */
 class IRunnable {
 public:
@@ -16,8 +19,38 @@ public:
 	//! \brief Cleans the object up
 	virtual void Cleanup() = 0;
 
-	//! \brief Starts the object
-	virtual void Run() = 0;
+	/*! \brief Advances the object a single step
+	 *  \param fStep Length of the step, in seconds
+	 *
+	 *  This handles input and all state changes.
+	 */
+	virtual void Update(float fStep) = 0;
+
+	/*! \brief Draws the current state
+	 *  \param fAlpha Fraction of the next step which has already passed
+	 *
+	 *  Motion may be extrapolated by fAlpha of a step to make it smooth
+	 *  when frames and steps don't line up. The buffers are swapped by the
+	 *  caller.
+	 */
+	virtual void Render(float fAlpha) = 0;
+
+	//! \brief Should the object stop running?
+	virtual bool IsFinished() = 0;
+
+	/*! \brief Has anything changed since the last Render()?
+	 *
+	 *  Frames are only drawn if this holds; the previous frame stays on
+	 *  screen otherwise.
+	 */
+	virtual bool IsDirty() { return true; }
+
+	/*! \brief Does nothing change until there is input?
+	 *
+	 *  If so, the caller may stop stepping and wait for input instead; the
+	 *  time spent waiting is not passed to Update().
+	 */
+	virtual bool IsIdle() { return false; }
 };
 
 #endif /*  __RUNNABLE_H__ */
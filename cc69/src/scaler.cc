@@ -0,0 +1,245 @@
+#include "scaler.h"
+#include <SDL/SDL.h>
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include "cpu.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#define HAVE_SSE2_KERNELS
+#endif
+
+void
+Scaler::CalculateFit(int iWidth, int iHeight, int iAreaWidth, int iAreaHeight, int& iFitWidth, int& iFitHeight)
+{
+	// Images which already fit are never enlarged
+	if (iWidth <= iAreaWidth && iHeight <= iAreaHeight) {
+		iFitWidth = iWidth;
+		iFitHeight = iHeight;
+		return;
+	}
+
+	float fScaleX = (float)iAreaWidth / (float)iWidth;
+	float fScaleY = (float)iAreaHeight / (float)iHeight;
+	float fScale = (fScaleX < fScaleY) ? fScaleX : fScaleY;
+	iFitWidth = (int)(iWidth * fScale);
+	iFitHeight = (int)(iHeight * fScale);
+	if (iFitWidth < 1)
+		iFitWidth = 1;
+	if (iFitHeight < 1)
+		iFitHeight = 1;
+}
+
+void
+Scaler::CalculateContributions(int iSource, int iDest, TContributionVector& oContributions, TWeightVector& oWeights)
+{
+	assert(iDest > 0 && iDest <= iSource);
+	double fRatio = (double)iSource / (double)iDest;
+
+	oContributions.resize(iDest);
+	oWeights.clear();
+	for (int i = 0; i < iDest; i++) {
+		/*
+		 * Destination pixel i covers source range [fStart, fEnd); every source
+		 * pixel in there contributes by the amount of overlap.
+		 */
+		double fStart = i * fRatio;
+		double fEnd = (i + 1) * fRatio;
+		int iFirst = (int)floor(fStart);
+		int iLast = (int)ceil(fEnd) - 1;
+		if (iLast >= iSource)
+			iLast = iSource - 1;
+
+		Contribution& oContribution = oContributions[i];
+		oContribution.m_iFirst = iFirst;
+		oContribution.m_iCount = iLast - iFirst + 1;
+		oContribution.m_iWeight = oWeights.size();
+
+		int32_t iTotal = 0;
+		int iLargest = oWeights.size();
+		for (int s = iFirst; s <= iLast; s++) {
+			double fOverlap = std::min((double)(s + 1), fEnd) - std::max((double)s, fStart);
+			int32_t iWeight = (int32_t)(fOverlap / fRatio * (1 << m_ciWeightBits) + 0.5);
+			oWeights.push_back(iWeight);
+			if (iWeight > oWeights[iLargest])
+				iLargest = oWeights.size() - 1;
+			iTotal += iWeight;
+		}
+
+		// Ensure the weights add up exactly, so that flat areas stay flat
+		oWeights[iLargest] += (1 << m_ciWeightBits) - iTotal;
+	}
+}
+
+void
+Scaler::FilterRowsScalar(const uint8_t** pRows, const int32_t* pWeights, int iCount, uint8_t* pDest, int iBytes)
+{
+	for (int i = 0; i < iBytes; i++) {
+		int32_t iValue = 1 << (m_ciWeightBits - 1);
+		for (int n = 0; n < iCount; n++)
+			iValue += pRows[n][i] * pWeights[n];
+		pDest[i] = iValue >> m_ciWeightBits;
+	}
+}
+
+void
+Scaler::FilterColumnsScalar(const uint8_t* pSource, const TContributionVector& oContributions, const TWeightVector& oWeights, uint8_t* pDest, int iBytesPerPixel)
+{
+	for (TContributionVector::const_iterator it = oContributions.begin(); it != oContributions.end(); it++) {
+		const int32_t* pWeights = &oWeights[it->m_iWeight];
+		for (int c = 0; c < iBytesPerPixel; c++) {
+			const uint8_t* pPixel = pSource + it->m_iFirst * iBytesPerPixel + c;
+			int32_t iValue = 1 << (m_ciWeightBits - 1);
+			for (int n = 0; n < it->m_iCount; n++, pPixel += iBytesPerPixel)
+				iValue += *pPixel * pWeights[n];
+			*pDest++ = iValue >> m_ciWeightBits;
+		}
+	}
+}
+
+#ifdef HAVE_SSE2_KERNELS
+/*
+ * The SSE2 kernels widen the pixel bytes to 32-bit lanes of which the upper
+ * 16 bits are zero; _mm_madd_epi16() against a weight in the lower 16 bits then
+ * yields the 32-bit product directly.
+ */
+__attribute__((target("sse2"))) void
+Scaler::FilterRowsSSE2(const uint8_t** pRows, const int32_t* pWeights, int iCount, uint8_t* pDest, int iBytes)
+{
+	const __m128i oZero = _mm_setzero_si128();
+	const __m128i oRound = _mm_set1_epi32(1 << (m_ciWeightBits - 1));
+
+	int i = 0;
+	for (/* nothing */; i + 16 <= iBytes; i += 16) {
+		__m128i oAcc0 = oRound, oAcc1 = oRound, oAcc2 = oRound, oAcc3 = oRound;
+		for (int n = 0; n < iCount; n++) {
+			__m128i oWeight = _mm_set1_epi32(pWeights[n]);
+			__m128i oPixels = _mm_loadu_si128((const __m128i*)(pRows[n] + i));
+			__m128i oLo = _mm_unpacklo_epi8(oPixels, oZero);
+			__m128i oHi = _mm_unpackhi_epi8(oPixels, oZero);
+			oAcc0 = _mm_add_epi32(oAcc0, _mm_madd_epi16(_mm_unpacklo_epi16(oLo, oZero), oWeight));
+			oAcc1 = _mm_add_epi32(oAcc1, _mm_madd_epi16(_mm_unpackhi_epi16(oLo, oZero), oWeight));
+			oAcc2 = _mm_add_epi32(oAcc2, _mm_madd_epi16(_mm_unpacklo_epi16(oHi, oZero), oWeight));
+			oAcc3 = _mm_add_epi32(oAcc3, _mm_madd_epi16(_mm_unpackhi_epi16(oHi, oZero), oWeight));
+		}
+		oAcc0 = _mm_srli_epi32(oAcc0, m_ciWeightBits);
+		oAcc1 = _mm_srli_epi32(oAcc1, m_ciWeightBits);
+		oAcc2 = _mm_srli_epi32(oAcc2, m_ciWeightBits);
+		oAcc3 = _mm_srli_epi32(oAcc3, m_ciWeightBits);
+		__m128i oResult = _mm_packus_epi16(_mm_packs_epi32(oAcc0, oAcc1), _mm_packs_epi32(oAcc2, oAcc3));
+		_mm_storeu_si128((__m128i*)(pDest + i), oResult);
+	}
+
+	// Handle whatever is left the slow way
+	for (/* nothing */; i < iBytes; i++) {
+		int32_t iValue = 1 << (m_ciWeightBits - 1);
+		for (int n = 0; n < iCount; n++)
+			iValue += pRows[n][i] * pWeights[n];
+		pDest[i] = iValue >> m_ciWeightBits;
+	}
+}
+
+__attribute__((target("sse2"))) void
+Scaler::FilterColumnsSSE2(const uint8_t* pSource, const TContributionVector& oContributions, const TWeightVector& oWeights, uint8_t* pDest, int iBytesPerPixel)
+{
+	const __m128i oZero = _mm_setzero_si128();
+	const __m128i oRound = _mm_set1_epi32(1 << (m_ciWeightBits - 1));
+
+	for (TContributionVector::const_iterator it = oContributions.begin(); it != oContributions.end(); it++) {
+		const int32_t* pWeights = &oWeights[it->m_iWeight];
+		const uint8_t* pPixel = pSource + it->m_iFirst * iBytesPerPixel;
+
+		// Process all channels of a pixel at once; for 24-bit, the 4th is ignored
+		__m128i oAcc = oRound;
+		for (int n = 0; n < it->m_iCount; n++, pPixel += iBytesPerPixel) {
+			int32_t iPixel;
+			memcpy(&iPixel, pPixel, sizeof(iPixel));
+			__m128i oPixel = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(iPixel), oZero), oZero);
+			oAcc = _mm_add_epi32(oAcc, _mm_madd_epi16(oPixel, _mm_set1_epi32(pWeights[n])));
+		}
+		oAcc = _mm_srli_epi32(oAcc, m_ciWeightBits);
+		oAcc = _mm_packus_epi16(_mm_packs_epi32(oAcc, oZero), oZero);
+
+		int32_t iResult = _mm_cvtsi128_si32(oAcc);
+		memcpy(pDest, &iResult, iBytesPerPixel);
+		pDest += iBytesPerPixel;
+	}
+}
+#else
+void
+Scaler::FilterRowsSSE2(const uint8_t** pRows, const int32_t* pWeights, int iCount, uint8_t* pDest, int iBytes)
+{
+	FilterRowsScalar(pRows, pWeights, iCount, pDest, iBytes);
+}
+
+void
+Scaler::FilterColumnsSSE2(const uint8_t* pSource, const TContributionVector& oContributions, const TWeightVector& oWeights, uint8_t* pDest, int iBytesPerPixel)
+{
+	FilterColumnsScalar(pSource, oContributions, oWeights, pDest, iBytesPerPixel);
+}
+#endif /* HAVE_SSE2_KERNELS */
+
+void
+Scaler::Scale(SDL_Surface* pSource, SDL_Surface* pDest, bool bAllowSIMD /* = true */)
+{
+	int iBytesPerPixel = pSource->format->BytesPerPixel;
+	assert(iBytesPerPixel == 3 || iBytesPerPixel == 4);
+	assert(iBytesPerPixel == pDest->format->BytesPerPixel);
+	assert(pDest->w <= pSource->w && pDest->h <= pSource->h);
+
+	TContributionVector oColumns, oRows;
+	TWeightVector oColumnWeights, oRowWeights;
+	CalculateContributions(pSource->w, pDest->w, oColumns, oColumnWeights);
+	CalculateContributions(pSource->h, pDest->h, oRows, oRowWeights);
+
+	/*
+	 * Filter vertically first, into a single intermediate row, and then
+	 * horizontally into the destination; this keeps everything in the cache.
+	 * The intermediate row is padded as the column filter may read a byte
+	 * past the final 24-bit pixel.
+	 */
+	int iRowBytes = pSource->w * iBytesPerPixel;
+	std::vector<uint8_t> oRow(iRowBytes + sizeof(uint32_t));
+	std::vector<const uint8_t*> oSourceRows;
+	bool bSIMD = bAllowSIMD && CPU::HasSSE2();
+	for (int y = 0; y < pDest->h; y++) {
+		const Contribution& oContribution = oRows[y];
+		oSourceRows.resize(oContribution.m_iCount);
+		for (int n = 0; n < oContribution.m_iCount; n++)
+			oSourceRows[n] = (const uint8_t*)pSource->pixels + (oContribution.m_iFirst + n) * pSource->pitch;
+
+		uint8_t* pDestRow = (uint8_t*)pDest->pixels + y * pDest->pitch;
+		if (bSIMD) {
+			FilterRowsSSE2(&oSourceRows[0], &oRowWeights[oContribution.m_iWeight], oContribution.m_iCount, &oRow[0], iRowBytes);
+			FilterColumnsSSE2(&oRow[0], oColumns, oColumnWeights, pDestRow, iBytesPerPixel);
+		} else {
+			FilterRowsScalar(&oSourceRows[0], &oRowWeights[oContribution.m_iWeight], oContribution.m_iCount, &oRow[0], iRowBytes);
+			FilterColumnsScalar(&oRow[0], oColumns, oColumnWeights, pDestRow, iBytesPerPixel);
+		}
+	}
+}
+
+SDL_Surface*
+Scaler::Fit(SDL_Surface* pSurface, int iWidth, int iHeight)
+{
+	if (pSurface->format->BytesPerPixel != 3 && pSurface->format->BytesPerPixel != 4)
+		return NULL;
+
+	int iFitWidth, iFitHeight;
+	CalculateFit(pSurface->w, pSurface->h, iWidth, iHeight, iFitWidth, iFitHeight);
+	if (iFitWidth == pSurface->w && iFitHeight == pSurface->h)
+		return NULL;
+
+	SDL_PixelFormat* pFormat = pSurface->format;
+	SDL_Surface* pScaled = SDL_CreateRGBSurface(SDL_SWSURFACE, iFitWidth, iFitHeight,
+	 pFormat->BitsPerPixel, pFormat->Rmask, pFormat->Gmask, pFormat->Bmask, pFormat->Amask);
+	if (pScaled == NULL)
+		return NULL;
+
+	Scale(pSurface, pScaled);
+	return pScaled;
+}
+
+/* vim:set ts=2 sw=2: */
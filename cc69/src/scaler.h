@@ -0,0 +1,105 @@
+#ifndef __SCALER_H__
+#define __SCALER_H__
+
+#include <stdint.h>
+#include <vector>
+
+typedef struct SDL_Surface SDL_Surface;
+
+/*! \brief Downscales images on the CPU
+ *
+ *  This uses a box filter: every destination pixel is the area-weighted
+ *  average of the source pixels it covers. This looks a lot better than
+ *  having OpenGL shrink the image using GL_NEAREST, and we don't need to
+ *  upload pixels that will never be shown.
+ */
+class Scaler
+{
+public:
+	/*! \brief Scales a surface down to fit an area
+	 *  \param pSurface Surface to scale
+	 *  \param iWidth Width of the area, in pixels
+	 *  \param iHeight Height of the area, in pixels
+	 *  \returns New surface on success, NULL if no scaling is necessary or possible
+	 *
+	 *  The aspect ratio is retained. Only 24 and 32-bit surfaces are scaled;
+	 *  the resulting surface uses the same pixel format as the source.
+	 */
+	static SDL_Surface* Fit(SDL_Surface* pSurface, int iWidth, int iHeight);
+
+	/*! \brief Scales a surface into another surface
+	 *  \param pSource Source surface
+	 *  \param pDest Destination surface, which must not be larger than pSource
+	 *  \param bAllowSIMD If false, SIMD instructions will not be used
+	 *
+	 *  Both surfaces must have the same format. The SIMD and scalar code
+	 *  paths yield identical results.
+	 */
+	static void Scale(SDL_Surface* pSource, SDL_Surface* pDest, bool bAllowSIMD = true);
+
+	/*! \brief Calculates the size of an image scaled to fit an area
+	 *  \param iWidth Image width, in pixels
+	 *  \param iHeight Image height, in pixels
+	 *  \param iAreaWidth Area width, in pixels
+	 *  \param iAreaHeight Area height, in pixels
+	 *  \param iFitWidth Receives the scaled width, in pixels
+	 *  \param iFitHeight Receives the scaled height, in pixels
+	 *
+	 *  The aspect ratio is retained; images which already fit are never
+	 *  enlarged.
+	 */
+	static void CalculateFit(int iWidth, int iHeight, int iAreaWidth, int iAreaHeight, int& iFitWidth, int& iFitHeight);
+
+protected:
+	/*! \brief Number of bits of precision in the filter weights
+	 *
+	 *  Weights of a single destination pixel add up to 1 << m_ciWeightBits;
+	 *  this must be below 15 as the SIMD code uses signed 16-bit weights.
+	 */
+	static const int m_ciWeightBits = 14;
+
+	//! \brief Filter contributions for a single destination row or column
+	struct Contribution {
+		//! \brief First source row or column
+		int m_iFirst;
+
+		//! \brief Number of source rows or columns
+		int m_iCount;
+
+		//! \brief Offset of the first weight in the weight vector
+		int m_iWeight;
+	};
+
+	typedef std::vector<Contribution> TContributionVector;
+	typedef std::vector<int32_t> TWeightVector;
+
+	/*! \brief Calculates the filter contributions along an axis
+	 *  \param iSource Source size, in pixels
+	 *  \param iDest Destination size, in pixels
+	 *  \param oContributions Filled with a contribution per destination pixel
+	 *  \param oWeights Filled with the weights
+	 */
+	static void CalculateContributions(int iSource, int iDest, TContributionVector& oContributions, TWeightVector& oWeights);
+
+	/*! \brief Filters a set of source rows into a single row
+	 *  \param pRows Source rows
+	 *  \param pWeights Weight of each source row
+	 *  \param iCount Number of source rows
+	 *  \param pDest Destination row
+	 *  \param iBytes Number of bytes per row
+	 */
+	static void FilterRowsScalar(const uint8_t** pRows, const int32_t* pWeights, int iCount, uint8_t* pDest, int iBytes);
+	static void FilterRowsSSE2(const uint8_t** pRows, const int32_t* pWeights, int iCount, uint8_t* pDest, int iBytes);
+
+	/*! \brief Filters a row horizontally
+	 *  \param pSource Source row; must be readable up to 4 bytes per pixel
+	 *  \param oContributions Contribution per destination pixel
+	 *  \param oWeights Filter weights
+	 *  \param pDest Destination row
+	 *  \param iBytesPerPixel Number of bytes per pixel, 3 or 4
+	 */
+	static void FilterColumnsScalar(const uint8_t* pSource, const TContributionVector& oContributions, const TWeightVector& oWeights, uint8_t* pDest, int iBytesPerPixel);
+	static void FilterColumnsSSE2(const uint8_t* pSource, const TContributionVector& oContributions, const TWeightVector& oWeights, uint8_t* pDest, int iBytesPerPixel);
+};
+
+#endif /* __SCALER_H__ */
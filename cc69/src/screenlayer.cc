@@ -0,0 +1,79 @@
+#include "screenlayer.h"
+#include "app.h"
+#include "glextensions.h"
+#include "spritebatch.h"
+
+ScreenLayer::ScreenLayer()
+	: m_iTexture(0), m_iTextureWidth(0), m_iTextureHeight(0), m_bValid(false)
+{
+}
+
+ScreenLayer::~ScreenLayer()
+{
+	Unload();
+}
+
+void
+ScreenLayer::Capture()
+{
+	int iWidth = g_oApp.GetScreenWidth();
+	int iHeight = g_oApp.GetScreenHeight();
+
+	if (m_iTexture == 0) {
+		m_iTextureWidth = iWidth;
+		m_iTextureHeight = iHeight;
+		if (!GLExtensions::HasNonPowerOfTwoTextures()) {
+			m_iTextureWidth = 1;
+			while (m_iTextureWidth < iWidth)
+				m_iTextureWidth <<= 1;
+			m_iTextureHeight = 1;
+			while (m_iTextureHeight < iHeight)
+				m_iTextureHeight <<= 1;
+		}
+
+		/*
+		 * The texture is kept to ourselves rather than shared through the
+		 * TexturePool, as its parameters differ from those of image textures.
+		 */
+		glGenTextures(1, &m_iTexture);
+		glBindTexture(GL_TEXTURE_2D, m_iTexture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_iTextureWidth, m_iTextureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	} else {
+		glBindTexture(GL_TEXTURE_2D, m_iTexture);
+	}
+
+	/*
+	 * This copies within video memory; it is a lot cheaper than rendering
+	 * everything again, and needs no extensions.
+	 */
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, iWidth, iHeight);
+	m_bValid = true;
+}
+
+void
+ScreenLayer::Render(float fDepth)
+{
+	float fWidth = (float)g_oApp.GetScreenWidth();
+	float fHeight = (float)g_oApp.GetScreenHeight();
+
+	// OpenGL puts the bottom row first, so the texture must be flipped
+	g_oApp.GetSpriteBatch().AddRect(m_iTexture, SpriteBatch::Blend(),
+	 0.0f, 0.0f, fWidth, fHeight, fDepth,
+	 0.0f, fHeight / m_iTextureHeight, fWidth / m_iTextureWidth, 0.0f);
+}
+
+void
+ScreenLayer::Unload()
+{
+	if (m_iTexture != 0) {
+		glDeleteTextures(1, &m_iTexture);
+		m_iTexture = 0;
+	}
+	m_bValid = false;
+}
+
+/* vim:set ts=2 sw=2: */
@@ -0,0 +1,60 @@
+#ifndef __SCREENLAYER_H__
+#define __SCREENLAYER_H__
+
+#include <GL/gl.h>
+
+/*! \brief Texture holding a copy of a rendered screen
+ *
+ *  This is used to cache parts of a frame which rarely change: they are
+ *  rendered once, captured from the back buffer and from then on drawn
+ *  using a single quad until the layer is invalidated.
+ *
+ *  The layer must only be used by the main thread.
+ */
+class ScreenLayer
+{
+public:
+	//! \brief Constructs an empty, invalid layer
+	ScreenLayer();
+
+	//! \brief Destroys the layer
+	~ScreenLayer();
+
+	/*! \brief Copies the back buffer into the layer
+	 *
+	 *  Anything still in the SpriteBatch must have been flushed first.
+	 *  Afterwards, the layer is valid.
+	 */
+	void Capture();
+
+	/*! \brief Submits the layer to the sprite batch
+	 *  \param fDepth Depth to render at
+	 *
+	 *  The layer covers the entire screen and is drawn without blending.
+	 */
+	void Render(float fDepth);
+
+	//! \brief Does the layer hold the current contents?
+	bool IsValid() const { return m_bValid; }
+
+	//! \brief Marks the layer as outdated, so that it must be captured again
+	void Invalidate() { m_bValid = false; }
+
+	//! \brief Throws the texture away
+	void Unload();
+
+private:
+	//! \brief OpenGL texture, if any
+	GLuint m_iTexture;
+
+	//! \brief Texture width, in pixels
+	int m_iTextureWidth;
+
+	//! \brief Texture height, in pixels
+	int m_iTextureHeight;
+
+	//! \brief Does the texture hold the current contents?
+	bool m_bValid;
+};
+
+#endif /* __SCREENLAYER_H__ */
@@ -0,0 +1,146 @@
+#include "sharedcontext.h"
+#include <SDL/SDL.h>
+#include <SDL/SDL_syswm.h>
+#include <GL/glx.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <iostream>
+#include "app.h"
+
+Display* SharedContext::m_pDisplay = NULL;
+unsigned long SharedContext::m_uiWindow = 0;
+SharedContext::TContextVector SharedContext::m_oContexts;
+SharedContext::TContextVector SharedContext::m_oAvailable;
+boost::mutex SharedContext::m_oLock;
+boost::thread_specific_ptr<GLXContext> SharedContext::m_oCurrent(SharedContext::Detach);
+
+void
+SharedContext::InitThreads()
+{
+	XInitThreads();
+}
+
+bool
+SharedContext::Init(int iNumContexts)
+{
+	SDL_SysWMinfo oInfo;
+	SDL_VERSION(&oInfo.version);
+	if (SDL_GetWMInfo(&oInfo) <= 0 || oInfo.subsystem != SDL_SYSWM_X11)
+		return false;
+
+	// SDL creates its OpenGL context using the graphics display
+	m_pDisplay = oInfo.info.x11.gfxdisplay;
+	m_uiWindow = oInfo.info.x11.window;
+	GLXContext pMainContext = glXGetCurrentContext();
+	if (pMainContext == NULL)
+		return false;
+
+	// Our contexts must use the same visual as the window
+	XWindowAttributes oAttributes;
+	if (!XGetWindowAttributes(m_pDisplay, m_uiWindow, &oAttributes))
+		return false;
+	XVisualInfo oTemplate;
+	oTemplate.visualid = XVisualIDFromVisual(oAttributes.visual);
+	int iNumVisuals;
+	XVisualInfo* pVisual = XGetVisualInfo(m_pDisplay, VisualIDMask, &oTemplate, &iNumVisuals);
+	if (pVisual == NULL)
+		return false;
+
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	for (int n = 0; n < iNumContexts; n++) {
+		GLXContext pContext = glXCreateContext(m_pDisplay, pVisual, pMainContext, True);
+		if (pContext == NULL)
+			break;
+		m_oContexts.push_back(pContext);
+		m_oAvailable.push_back(pContext);
+	}
+	XFree(pVisual);
+
+	if (g_oApp.IsVerbose())
+		std::cerr << "SharedContext: created " << m_oContexts.size() << " contexts, " <<
+		 (GLExtensions::HasSync() ? "using sync objects" : "waiting for uploads to complete") << "\n";
+	return !m_oContexts.empty();
+}
+
+void
+SharedContext::Cleanup()
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	for (TContextVector::iterator it = m_oContexts.begin(); it != m_oContexts.end(); it++)
+		glXDestroyContext(m_pDisplay, *it);
+	m_oContexts.clear();
+	m_oAvailable.clear();
+}
+
+bool
+SharedContext::Attach()
+{
+	if (m_oCurrent.get() != NULL)
+		return true;
+
+	GLXContext pContext;
+	{
+		boost::unique_lock<boost::mutex> oLock(m_oLock);
+		if (m_oAvailable.empty())
+			return false;
+		pContext = m_oAvailable.back();
+		m_oAvailable.pop_back();
+	}
+
+	/*
+	 * We never draw anything, but a context must be bound to a drawable;
+	 * the window will do as it has the correct visual.
+	 */
+	if (!glXMakeCurrent(m_pDisplay, m_uiWindow, pContext)) {
+		// Leave the context for Cleanup(); retrying will not help
+		return false;
+	}
+	m_oCurrent.reset(new GLXContext(pContext));
+	return true;
+}
+
+void
+SharedContext::Detach(GLXContext* pContext)
+{
+	glXMakeCurrent(m_pDisplay, None, NULL);
+
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	m_oAvailable.push_back(*pContext);
+	delete pContext;
+}
+
+GLsync
+SharedContext::InsertFence()
+{
+	if (!GLExtensions::HasSync()) {
+		glFinish();
+		return NULL;
+	}
+
+	// Flush so that the fence will actually be reached
+	GLsync pFence = GLExtensions::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+	return pFence;
+}
+
+bool
+SharedContext::IsFenceSignalled(GLsync pFence)
+{
+	// Treat failure as signalled; waiting would not make it any better
+	return GLExtensions::ClientWaitSync(pFence, 0, 0) != GL_TIMEOUT_EXPIRED;
+}
+
+void
+SharedContext::WaitFence(GLsync pFence)
+{
+	GLExtensions::WaitSync(pFence, 0, GL_TIMEOUT_IGNORED);
+	GLExtensions::DeleteSync(pFence);
+}
+
+void
+SharedContext::DeleteFence(GLsync pFence)
+{
+	GLExtensions::DeleteSync(pFence);
+}
+
+/* vim:set ts=2 sw=2: */
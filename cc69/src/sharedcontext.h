@@ -0,0 +1,98 @@
+#ifndef __SHAREDCONTEXT_H__
+#define __SHAREDCONTEXT_H__
+
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include "glextensions.h"
+
+typedef struct _XDisplay Display;
+typedef struct __GLXcontextRec* GLXContext;
+
+/*! \brief OpenGL contexts sharing their objects with the main context
+ *
+ *  Normally, only the main thread may perform OpenGL calls. Once Init() is
+ *  called, other threads may Attach() to a context of their own which
+ *  shares textures with the main context; this allows them to upload
+ *  textures themselves. A thread gives up its context when it terminates.
+ *
+ *  As every context has its own command stream, the main thread must not use
+ *  such a texture until the fence placed after the upload has passed.
+ */
+class SharedContext
+{
+public:
+	/*! \brief Enables multithreaded X11 use
+	 *
+	 *  This must be called before SDL is initialized.
+	 */
+	static void InitThreads();
+
+	/*! \brief Creates the shared contexts
+	 *  \param iNumContexts Number of contexts to create
+	 *  \returns true on success
+	 *
+	 *  This must be called by the main thread once the video mode is set.
+	 */
+	static bool Init(int iNumContexts);
+
+	/*! \brief Destroys the shared contexts
+	 *
+	 *  This must be called by the main thread once every thread that
+	 *  attached to a context has terminated.
+	 */
+	static void Cleanup();
+
+	/*! \brief Attaches the calling thread to a context, if it has none yet
+	 *  \returns true if the thread has a context
+	 */
+	static bool Attach();
+
+	//! \brief Does the calling thread have a context?
+	static bool IsAttached() { return m_oCurrent.get() != NULL; }
+
+	/*! \brief Marks the completion of all OpenGL work done so far
+	 *  \returns Fence to wait for, or NULL if the work is already complete
+	 *
+	 *  If sync objects are unavailable, this waits for the work to complete.
+	 */
+	static GLsync InsertFence();
+
+	//! \brief Has the work preceding a fence completed?
+	static bool IsFenceSignalled(GLsync pFence);
+
+	/*! \brief Makes subsequent OpenGL work wait for a fence
+	 *
+	 *  This does not block the caller; the fence is destroyed.
+	 */
+	static void WaitFence(GLsync pFence);
+
+	//! \brief Destroys a fence
+	static void DeleteFence(GLsync pFence);
+
+private:
+	//! \brief Gives up the context of a terminating thread
+	static void Detach(GLXContext* pContext);
+
+	typedef std::vector<GLXContext> TContextVector;
+
+	//! \brief X11 display used by the main context
+	static Display* m_pDisplay;
+
+	//! \brief X11 window used by the main context
+	static unsigned long m_uiWindow;
+
+	//! \brief All contexts created
+	static TContextVector m_oContexts;
+
+	//! \brief Contexts no thread is attached to
+	static TContextVector m_oAvailable;
+
+	//! \brief Lock protecting m_oAvailable
+	static boost::mutex m_oLock;
+
+	//! \brief Context of the calling thread, if any
+	static boost::thread_specific_ptr<GLXContext> m_oCurrent;
+};
+
+#endif /* __SHAREDCONTEXT_H__ */
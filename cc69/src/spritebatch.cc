@@ -0,0 +1,150 @@
+#include "spritebatch.h"
+#include <algorithm>
+#include <iostream>
+#include "app.h"
+
+class SpriteBatch::CompareSprites {
+public:
+	CompareSprites(const TSpriteVector& oSprites) : m_oSprites(oSprites) { }
+
+	bool operator()(unsigned int iA, unsigned int iB) const {
+		const Sprite& oA = m_oSprites[iA];
+		const Sprite& oB = m_oSprites[iB];
+		if (oA.m_fDepth != oB.m_fDepth)
+			return oA.m_fDepth < oB.m_fDepth;
+		if (oA.m_oBlend != oB.m_oBlend)
+			return oA.m_oBlend < oB.m_oBlend;
+		return oA.m_iTexture < oB.m_iTexture;
+	}
+
+private:
+	const TSpriteVector& m_oSprites;
+};
+
+void
+SpriteBatch::Blend::Apply() const
+{
+	if (!IsEnabled()) {
+		glDisable(GL_BLEND);
+		return;
+	}
+	glEnable(GL_BLEND);
+	glBlendFunc(m_eSource, m_eDest);
+	glBlendColor(1.0f, 1.0f, 1.0f, m_fConstantAlpha);
+}
+
+SpriteBatch::SpriteBatch()
+	: m_uiNumSprites(0), m_uiNumDrawCalls(0)
+{
+}
+
+SpriteBatch::~SpriteBatch()
+{
+	if (g_oApp.IsVerbose())
+		std::cerr << "SpriteBatch: drew " << m_uiNumSprites << " sprites using " << m_uiNumDrawCalls << " draw calls\n";
+}
+
+uint32_t
+SpriteBatch::MakeColor(float fR, float fG, float fB, float fA)
+{
+	// Clamp the components; blend animations may overshoot a bit
+	fR = std::max(0.0f, std::min(fR, 1.0f));
+	fG = std::max(0.0f, std::min(fG, 1.0f));
+	fB = std::max(0.0f, std::min(fB, 1.0f));
+	fA = std::max(0.0f, std::min(fA, 1.0f));
+	return (uint32_t)(fA * 255.0f + 0.5f) << 24 | (uint32_t)(fR * 255.0f + 0.5f) << 16 |
+	       (uint32_t)(fG * 255.0f + 0.5f) << 8 | (uint32_t)(fB * 255.0f + 0.5f);
+}
+
+void
+SpriteBatch::AddRect(GLuint iTexture, const Blend& oBlend,
+                     float fLeft, float fTop, float fRight, float fBottom, float fDepth,
+                     float fTexLeft, float fTexTop, float fTexRight, float fTexBottom,
+                     uint32_t uiColor /* = m_ciWhite */)
+{
+	float afX[4] = { fLeft, fRight, fRight, fLeft };
+	float afY[4] = { fTop, fTop, fBottom, fBottom };
+	AddQuad(iTexture, oBlend, afX, afY, fDepth, fTexLeft, fTexTop, fTexRight, fTexBottom, uiColor);
+}
+
+void
+SpriteBatch::AddQuad(GLuint iTexture, const Blend& oBlend,
+                     const float afX[4], const float afY[4], float fDepth,
+                     float fTexLeft, float fTexTop, float fTexRight, float fTexBottom,
+                     uint32_t uiColor /* = m_ciWhite */)
+{
+	m_oSprites.push_back(Sprite());
+	Sprite& oSprite = m_oSprites.back();
+	oSprite.m_iTexture = iTexture;
+	oSprite.m_oBlend = oBlend;
+	oSprite.m_fDepth = fDepth;
+
+	const float afU[4] = { fTexLeft, fTexRight, fTexRight, fTexLeft };
+	const float afV[4] = { fTexTop, fTexTop, fTexBottom, fTexBottom };
+	for (int n = 0; n < 4; n++) {
+		Vertex& oVertex = oSprite.m_aVertex[n];
+		oVertex.m_fU = afU[n];
+		oVertex.m_fV = afV[n];
+		oVertex.m_aColor[0] = (uiColor >> 16) & 0xff;
+		oVertex.m_aColor[1] = (uiColor >>  8) & 0xff;
+		oVertex.m_aColor[2] = (uiColor      ) & 0xff;
+		oVertex.m_aColor[3] = (uiColor >> 24) & 0xff;
+		oVertex.m_fX = afX[n];
+		oVertex.m_fY = afY[n];
+		oVertex.m_fZ = fDepth;
+	}
+}
+
+void
+SpriteBatch::Flush()
+{
+	if (m_oSprites.empty())
+		return;
+
+	/*
+	 * Determine the drawing order; the sort must be stable so that sprites
+	 * at the same depth and state keep the order in which they were added.
+	 */
+	m_oOrder.resize(m_oSprites.size());
+	for (unsigned int n = 0; n < m_oOrder.size(); n++)
+		m_oOrder[n] = n;
+	std::stable_sort(m_oOrder.begin(), m_oOrder.end(), CompareSprites(m_oSprites));
+
+	m_oVertices.resize(m_oSprites.size() * 4);
+	for (unsigned int n = 0; n < m_oOrder.size(); n++)
+		std::copy(m_oSprites[m_oOrder[n]].m_aVertex, m_oSprites[m_oOrder[n]].m_aVertex + 4, &m_oVertices[n * 4]);
+
+	// Our coordinates are in screen space already
+	glPushMatrix();
+	glLoadIdentity();
+	glInterleavedArrays(GL_T2F_C4UB_V3F, 0, &m_oVertices.front());
+
+	// Draw every run of sprites sharing the same state at once
+	unsigned int iFirst = 0;
+	while (iFirst < m_oOrder.size()) {
+		const Sprite& oSprite = m_oSprites[m_oOrder[iFirst]];
+		unsigned int iLast = iFirst + 1;
+		while (iLast < m_oOrder.size() &&
+		       m_oSprites[m_oOrder[iLast]].m_iTexture == oSprite.m_iTexture &&
+		       m_oSprites[m_oOrder[iLast]].m_oBlend == oSprite.m_oBlend)
+			iLast++;
+
+		oSprite.m_oBlend.Apply();
+		glBindTexture(GL_TEXTURE_2D, oSprite.m_iTexture);
+		glDrawArrays(GL_QUADS, iFirst * 4, (iLast - iFirst) * 4);
+		m_uiNumDrawCalls++;
+		iFirst = iLast;
+	}
+
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisable(GL_BLEND);
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+	glPopMatrix();
+
+	m_uiNumSprites += m_oSprites.size();
+	m_oSprites.clear();
+}
+
+/* vim:set ts=2 sw=2: */
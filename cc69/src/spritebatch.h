@@ -0,0 +1,154 @@
+#ifndef __SPRITEBATCH_H__
+#define __SPRITEBATCH_H__
+
+#include <GL/gl.h>
+#include <stdint.h>
+#include <vector>
+
+/*! \brief Collects textured quads and draws them using few draw calls
+ *
+ *  Rather than drawing every quad using glBegin()/glEnd() and its own
+ *  state changes, quads are added to the batch in screen coordinates. Once
+ *  the frame is complete, Flush() sorts them by depth, blend mode and
+ *  texture and draws every run of identical state using a single vertex
+ *  array call.
+ *
+ *  Quads are sorted back to front; quads with the same depth may be
+ *  reordered to group them by state, so overlapping quads need distinct
+ *  depths.
+ */
+class SpriteBatch
+{
+public:
+	//! \brief Blending used for a quad
+	class Blend {
+	public:
+		//! \brief No blending at all
+		Blend() : m_eSource(GL_ONE), m_eDest(GL_ZERO), m_fConstantAlpha(1.0f) { }
+
+		/*! \brief Blend using given factors
+		 *  \param eSource Source factor, as used by glBlendFunc()
+		 *  \param eDest Destination factor, as used by glBlendFunc()
+		 *  \param fConstantAlpha Alpha used by GL_CONSTANT_ALPHA factors
+		 */
+		Blend(GLenum eSource, GLenum eDest, float fConstantAlpha = 1.0f)
+		 : m_eSource(eSource), m_eDest(eDest), m_fConstantAlpha(fConstantAlpha)
+		{
+		}
+
+		//! \brief Is blending needed at all?
+		bool IsEnabled() const { return m_eSource != GL_ONE || m_eDest != GL_ZERO; }
+
+		bool operator==(const Blend& oBlend) const {
+			return m_eSource == oBlend.m_eSource && m_eDest == oBlend.m_eDest && m_fConstantAlpha == oBlend.m_fConstantAlpha;
+		}
+		bool operator!=(const Blend& oBlend) const { return !(*this == oBlend); }
+		bool operator<(const Blend& oBlend) const {
+			if (m_eSource != oBlend.m_eSource)
+				return m_eSource < oBlend.m_eSource;
+			if (m_eDest != oBlend.m_eDest)
+				return m_eDest < oBlend.m_eDest;
+			return m_fConstantAlpha < oBlend.m_fConstantAlpha;
+		}
+
+		//! \brief Applies the blend mode
+		void Apply() const;
+
+	private:
+		GLenum m_eSource;
+		GLenum m_eDest;
+		float m_fConstantAlpha;
+	};
+
+	//! \brief Constructs an empty batch
+	SpriteBatch();
+
+	//! \brief Destroys the batch
+	~SpriteBatch();
+
+	/*! \brief Adds an axis-aligned quad
+	 *  \param iTexture Texture to use, or 0 for none
+	 *  \param oBlend Blending to use
+	 *  \param fLeft Left screen coordinate
+	 *  \param fTop Top screen coordinate
+	 *  \param fRight Right screen coordinate
+	 *  \param fBottom Bottom screen coordinate
+	 *  \param fDepth Depth, where higher values are closer to the viewer
+	 *  \param fTexLeft Left texture coordinate
+	 *  \param fTexTop Top texture coordinate
+	 *  \param fTexRight Right texture coordinate
+	 *  \param fTexBottom Bottom texture coordinate
+	 *  \param uiColor Color to modulate the texture with, as 0xAARRGGBB
+	 */
+	void AddRect(GLuint iTexture, const Blend& oBlend,
+	             float fLeft, float fTop, float fRight, float fBottom, float fDepth,
+	             float fTexLeft, float fTexTop, float fTexRight, float fTexBottom,
+	             uint32_t uiColor = m_ciWhite);
+
+	/*! \brief Adds an arbitrary quad
+	 *  \param afX X screen coordinates of the top left, top right, bottom right and bottom left corner
+	 *  \param afY Y screen coordinates of the same corners
+	 *
+	 *  The remaining parameters are as for AddRect().
+	 */
+	void AddQuad(GLuint iTexture, const Blend& oBlend,
+	             const float afX[4], const float afY[4], float fDepth,
+	             float fTexLeft, float fTexTop, float fTexRight, float fTexBottom,
+	             uint32_t uiColor = m_ciWhite);
+
+	/*! \brief Draws everything added since the previous call
+	 *
+	 *  This must be called before the buffers are swapped, or before
+	 *  anything is drawn without using the batch. The modelview matrix is
+	 *  ignored; afterwards, blending is disabled.
+	 */
+	void Flush();
+
+	/*! \brief Constructs a color value
+	 *  \returns Color as 0xAARRGGBB
+	 */
+	static uint32_t MakeColor(float fR, float fG, float fB, float fA);
+
+	//! \brief Opaque white, which leaves textures as they are
+	static const uint32_t m_ciWhite = 0xffffffff;
+
+private:
+	//! \brief Vertex layout, as expected by GL_T2F_C4UB_V3F
+	struct Vertex {
+		GLfloat m_fU, m_fV;
+		GLubyte m_aColor[4];
+		GLfloat m_fX, m_fY, m_fZ;
+	};
+
+	//! \brief A single quad waiting to be drawn
+	struct Sprite {
+		GLuint m_iTexture;
+		Blend m_oBlend;
+		float m_fDepth;
+		Vertex m_aVertex[4];
+	};
+
+	//! \brief Orders sprites by index, as needed by Flush()
+	class CompareSprites;
+
+	typedef std::vector<Sprite> TSpriteVector;
+	typedef std::vector<unsigned int> TIndexVector;
+	typedef std::vector<Vertex> TVertexVector;
+
+	//! \brief Sprites added, in order
+	TSpriteVector m_oSprites;
+
+	//! \brief Sprite indices, in drawing order
+	TIndexVector m_oOrder;
+
+	//! \brief Vertices to draw, in drawing order
+	TVertexVector m_oVertices;
+
+	//! \brief Number of sprites drawn
+	unsigned int m_uiNumSprites;
+
+	//! \brief Number of draw calls issued
+	unsigned int m_uiNumDrawCalls;
+};
+
+#endif /* __SPRITEBATCH_H__ */
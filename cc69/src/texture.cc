@@ -1,11 +1,27 @@
 #include "texture.h"
 #include <assert.h>
+#include <algorithm>
 #include <SDL/SDL.h>
+#include "glextensions.h"
+#include "pixelconverter.h"
+#include "sharedcontext.h"
+#include "textureatlas.h"
+#include "texturepool.h"
+
+Texture::TFenceVector Texture::m_oDeferredFences;
+boost::mutex Texture::m_oDeferredLock;
+
+/*
+ * Static initialization is done by the thread running main(), which is the
+ * thread doing all OpenGL work.
+ */
+boost::thread::id Texture::m_oMainThread = boost::this_thread::get_id();
 
 Texture::Texture()
-	: m_iTexture(m_ciUndefinedTexture),
-	  m_fNormalizedHeight(1.0f), m_fNormalizedWidth(1.0f),
-		m_pTextureData(NULL)
+	: m_fNormalizedLeft(0.0f), m_fNormalizedTop(0.0f),
+	  m_fNormalizedWidth(1.0f), m_fNormalizedHeight(1.0f),
+		m_pTextureData(NULL), m_pPixelBuffer(NULL), m_iUploadedRows(0), m_pFence(NULL), m_uiPaddingSaved(0),
+		m_iTexture(m_ciUndefinedTexture), m_pAtlasPage(NULL), m_iAtlasX(0), m_iAtlasY(0)
 {
 }
 
@@ -37,12 +53,27 @@ Texture::RoundUp2(uint32_t n)
 	return n;
 }
 
+size_t
+Texture::CalculateDataSize(uint32_t iWidth, uint32_t iHeight)
+{
+	if (!GLExtensions::HasNonPowerOfTwoTextures()) {
+		iWidth = RoundUp2(iWidth);
+		iHeight = RoundUp2(iHeight);
+	}
+	return iWidth * iHeight * sizeof(uint32_t);
+}
+
 bool
-Texture::ConvertSurface(SDL_Surface* pSurface)
+Texture::ConvertSurface(SDL_Surface* pSurface, TextureAtlas* pAtlas, bool bStream)
 {
 	// Ensure nothing has yet been loaded
 	assert(m_iTexture == m_ciUndefinedTexture);
 	assert(m_pTextureData == NULL);
+	assert(m_pAtlasPage == NULL);
+
+	// If the atlas can take the surface, there is nothing left to do here
+	if (pAtlas != NULL && pAtlas->Add(*this, pSurface))
+		return true;
 
 	// We'll only handle RGB and RGBA images; anything else will likely break
 	if (pSurface->format->BytesPerPixel != 3 && pSurface->format->BytesPerPixel != 4)
@@ -53,12 +84,22 @@ Texture::ConvertSurface(SDL_Surface* pSurface)
 		return false;
 	GLint iColours = pSurface->format->BytesPerPixel;
 
-	// Convert the image
-	uint32_t iWidth = RoundUp2(pSurface->w);
-	uint32_t iHeight = RoundUp2(pSurface->h);
+	/*
+	 * Convert the image; if the OpenGL implementation can't handle textures
+	 * which are not a power of two in size, we need to pad them.
+	 */
+	uint32_t iWidth = pSurface->w;
+	uint32_t iHeight = pSurface->h;
+	m_uiPaddingSaved = 0;
+	if (GLExtensions::HasNonPowerOfTwoTextures()) {
+		m_uiPaddingSaved = (RoundUp2(iWidth) * RoundUp2(iHeight) - iWidth * iHeight) * sizeof(uint32_t);
+	} else {
+		iWidth = RoundUp2(iWidth);
+		iHeight = RoundUp2(iHeight);
+	}
 
 	/*
-	 * If image sizes aren't a power of two, we'll have to expand it. This is
+	 * If image sizes aren't a power of two, we may have to expand it. This is
 	 * tricky because we should make everything transparant that isn't in the
 	 * original image, which we can only do if there is an alpha channel.
 	 *
@@ -66,7 +107,12 @@ Texture::ConvertSurface(SDL_Surface* pSurface)
 	 * to throw the SDL surface away, we'll just always re-create the image so
 	 * that it can be fed to glTexImage2D() without any problems.
 	 */
-	m_pTextureData = new uint32_t[iHeight * iWidth];
+	if (bStream)
+		m_pPixelBuffer = PixelBufferPool::Acquire(iHeight * iWidth * sizeof(uint32_t));
+	if (m_pPixelBuffer != NULL)
+		m_pTextureData = (uint32_t*)m_pPixelBuffer->GetData();
+	else
+		m_pTextureData = new uint32_t[iHeight * iWidth];
 	unsigned int y = 0;
 	uint32_t* pImagePtr = m_pTextureData;
 	uint8_t* pixels = (uint8_t*)pSurface->pixels;
@@ -77,12 +123,9 @@ Texture::ConvertSurface(SDL_Surface* pSurface)
 			pixels += pSurface->w * sizeof(uint32_t);
 			pImagePtr += pSurface->w;
 		} else /* iColours == 3 */ {
-			for (unsigned int x = 0; x < pSurface->w; x++) {
-				uint32_t value = *pixels++;
-				value |= *pixels++ << 8;
-				value |= *pixels++ << 16;
-				*pImagePtr++ = value | 0xff000000 /* alpha */;
-			}
+			PixelConverter::ExpandRGBToRGBA(pixels, pImagePtr, pSurface->w);
+			pixels += pSurface->w * 3;
+			pImagePtr += pSurface->w;
 		}
 
 		// Skip anything extra on the scanline
@@ -100,7 +143,8 @@ Texture::ConvertSurface(SDL_Surface* pSurface)
 	 * Image all set - however, we cannot create it, since it's illegal to create
 	 * a texture from one thread and use it in another. This is solved by storing
 	 * the necessary information here and finally creating the image in the
-	 * GetTextureID() function, where it's guaranteed to be safe.
+	 * GetTextureID() function, where it's guaranteed to be safe - or in
+	 * UploadRows(), if our thread has an OpenGL context of its own.
 	 */
 	m_iTextureHeight = iHeight;
 	m_iTextureWidth = iWidth;
@@ -122,56 +166,217 @@ Texture::ConvertSurface(SDL_Surface* pSurface)
 GLuint
 Texture::GetTextureID()
 {
-	// If the texture isn't created, we must do so here
-	if (m_iTexture == m_ciUndefinedTexture) {
+	if (m_pAtlasPage != NULL)
+		return m_pAtlasPage->GetTextureID();
+
+	// If another thread uploaded the texture, the GPU must wait for that first
+	if (m_pFence != NULL) {
+		SharedContext::WaitFence(m_pFence);
+		m_pFence = NULL;
+	}
+
+	// If the texture isn't completely uploaded, we must do so here
+	if (!IsResident()) {
 		assert(m_pTextureData != NULL);
+		UploadRows(m_iTextureHeight);
+	}
+	return m_iTexture;
+}
+
+bool
+Texture::IsResident()
+{
+	if (m_pAtlasPage != NULL)
+		return m_pAtlasPage->IsResident();
+
+	if (m_iTexture == m_ciUndefinedTexture || m_pTextureData != NULL)
+		return false;
+
+	if (m_pFence != NULL) {
+		if (!SharedContext::IsFenceSignalled(m_pFence))
+			return false;
+		SharedContext::DeleteFence(m_pFence);
+		m_pFence = NULL;
+	}
+	return true;
+}
+
+bool
+Texture::CanUseOpenGL()
+{
+	return boost::this_thread::get_id() == m_oMainThread || SharedContext::IsAttached();
+}
+
+bool
+Texture::UploadRows(int iNumRows)
+{
+	assert(CanUseOpenGL());
+
+	if (m_pAtlasPage != NULL)
+		return m_pAtlasPage->UploadRows(iNumRows);
+
+	// If there is nothing left to upload, we may still be waiting for a fence
+	if (m_pTextureData == NULL)
+		return IsResident();
+
+	bool bMainThread = boost::this_thread::get_id() == m_oMainThread;
+	if (m_iTexture == m_ciUndefinedTexture) {
+		// Get rid of anything others are done with before we add a new one
+		TexturePool::Trim();
+		if (bMainThread) {
+			DeleteDeferredFences();
+			PixelBufferPool::Replenish();
+		}
 
-		// Construct the texture
-		assert(m_iTexture == m_ciUndefinedTexture);
-		glGenTextures(1, &m_iTexture);
-		assert(m_iTexture != m_ciUndefinedTexture);
+		/*
+		 * Reuse a texture of the same size if we can; its storage can be
+		 * overwritten as is. All its parameters are as set below.
+		 */
+		m_iTexture = TexturePool::Acquire(m_iTextureWidth, m_iTextureHeight, m_eTextureFormat);
+		if (m_iTexture != m_ciUndefinedTexture) {
+			glBindTexture(GL_TEXTURE_2D, m_iTexture);
+		} else {
+			// Construct the texture; its contents are filled in below
+			glGenTextures(1, &m_iTexture);
+			assert(m_iTexture != m_ciUndefinedTexture);
+			glBindTexture(GL_TEXTURE_2D, m_iTexture);
+
+			/*
+			 * Some implementations only handle non-power-of-two textures in hardware
+			 * if they are not repeated; we never rely on that anyway.
+			 */
+			GLint iWrap = (m_iTextureWidth == (int)RoundUp2(m_iTextureWidth) && m_iTextureHeight == (int)RoundUp2(m_iTextureHeight)) ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, iWrap);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, iWrap);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexImage2D(GL_TEXTURE_2D, 0, m_eTextureFormat, m_iTextureWidth, m_iTextureHeight, 0, m_eTextureFormat, GL_UNSIGNED_BYTE, NULL);
+		}
+		m_iUploadedRows = 0;
+	} else {
 		glBindTexture(GL_TEXTURE_2D, m_iTexture);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexImage2D(GL_TEXTURE_2D, 0, m_eTextureFormat, m_iTextureWidth, m_iTextureHeight, 0, m_eTextureFormat, GL_UNSIGNED_BYTE, (void*)m_pTextureData);
+	}
+
+	// Upload the next strip of rows
+	iNumRows = std::min(iNumRows, m_iTextureHeight - m_iUploadedRows);
+	size_t uiOffset = m_iUploadedRows * m_iTextureWidth;
+	if (m_pPixelBuffer != NULL) {
+		assert(bMainThread);
 
+		/*
+		 * The data is already in a pixel buffer; this just schedules the
+		 * upload from it, so we need not wait for the copy to complete.
+		 */
+		PixelBufferPool::Bind(m_pPixelBuffer);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, m_iUploadedRows, m_iTextureWidth, iNumRows, m_eTextureFormat, GL_UNSIGNED_BYTE, (void*)(uiOffset * sizeof(uint32_t)));
+		PixelBufferPool::Unbind();
+	} else {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, m_iUploadedRows, m_iTextureWidth, iNumRows, m_eTextureFormat, GL_UNSIGNED_BYTE, (void*)(m_pTextureData + uiOffset));
+	}
+	m_iUploadedRows += iNumRows;
+	if (m_iUploadedRows < m_iTextureHeight)
+		return false;
+
+	// Everything is uploaded; we no longer need the data
+	if (m_pPixelBuffer != NULL) {
+		PixelBufferPool::Release(m_pPixelBuffer);
+		m_pPixelBuffer = NULL;
+	} else {
 		/*
 		 * XXX We use the fact that it is possible to free memory allocated by
 		 * other threads; I'm not sure whether this is required behaviour.
 		 */
 		delete[] m_pTextureData;
-		m_pTextureData = NULL;
 	}
-	return m_iTexture;
+	m_pTextureData = NULL;
+
+	// Our context has its own command stream; the main thread must wait for it
+	if (!bMainThread) {
+		m_pFence = SharedContext::InsertFence();
+		return m_pFence == NULL;
+	}
+	return true;
 }
 
 void
 Texture::Unload()
 {
-	// Throw away the texture, if any
+	/*
+	 * Our part of an atlas page is not reclaimed; it remains in use until
+	 * the atlas itself is unloaded.
+	 */
+	if (m_pAtlasPage != NULL) {
+		m_pAtlasPage = NULL;
+		m_fNormalizedLeft = 0.0f;
+		m_fNormalizedTop = 0.0f;
+		return;
+	}
+
+	// Hand the texture, if any, to the pool for reuse
 	if (m_iTexture != m_ciUndefinedTexture) {
-		glDeleteTextures(1, &m_iTexture);
+		TexturePool::Release(m_iTexture, m_iTextureWidth, m_iTextureHeight, m_eTextureFormat);
 		m_iTexture = m_ciUndefinedTexture;
 	}
 
+	// Throw away the fence of an upload by another thread, if any
+	if (m_pFence != NULL) {
+		if (CanUseOpenGL()) {
+			SharedContext::DeleteFence(m_pFence);
+		} else {
+			boost::unique_lock<boost::mutex> oLock(m_oDeferredLock);
+			m_oDeferredFences.push_back(m_pFence);
+		}
+		m_pFence = NULL;
+	}
+
 	// Throw away the texture data, if any (see XXX in GetTextureID)
-	delete[] m_pTextureData;
+	if (m_pPixelBuffer != NULL) {
+		PixelBufferPool::Release(m_pPixelBuffer);
+		m_pPixelBuffer = NULL;
+	} else {
+		delete[] m_pTextureData;
+	}
 	m_pTextureData = NULL;
 
 }
 
+void
+Texture::DeleteDeferredFences()
+{
+	assert(boost::this_thread::get_id() == m_oMainThread);
+
+	boost::unique_lock<boost::mutex> oLock(m_oDeferredLock);
+	for (TFenceVector::iterator it = m_oDeferredFences.begin(); it != m_oDeferredFences.end(); it++)
+		SharedContext::DeleteFence(*it);
+	m_oDeferredFences.clear();
+}
+
 void
 Texture::Update(SDL_Surface* pSurface, int dstX, int dstY, int srcX, int srcY, int w, int h)
 {
 	assert(pSurface->format->BytesPerPixel == 4);
 	assert((pSurface->format->Rmask == 0xff) ? GL_RGBA : GL_BGRA == m_eTextureFormat);
 
+	if (m_pAtlasPage != NULL) {
+		m_pAtlasPage->Update(pSurface, m_iAtlasX + dstX, m_iAtlasY + dstY, srcX, srcY, w, h);
+		return;
+	}
+
+	// If nothing is uploaded yet, just change the data we will upload
+	uint8_t* pSource = (uint8_t*)pSurface->pixels + srcY * pSurface->pitch + srcX * sizeof(uint32_t);
+	if (m_pTextureData != NULL && m_iTexture == m_ciUndefinedTexture) {
+		uint32_t* pDest = m_pTextureData + dstY * m_iTextureWidth + dstX;
+		for (int ypos = 0; ypos < h; ypos++) {
+			memcpy(pDest, pSource, w * sizeof(uint32_t));
+			pDest += m_iTextureWidth;
+			pSource += pSurface->pitch;
+		}
+		return;
+	}
+
 	// Cut the section from the texture
 	uint8_t* pImageData = new uint8_t[h * w * sizeof(uint32_t)];
 	uint8_t* pDest = pImageData;
-	uint8_t* pSource = (uint8_t*)pSurface->pixels + srcY * pSurface->pitch + srcX * sizeof(uint32_t);
 	for (int ypos = 0; ypos < h; ypos++) {
 		memcpy(pDest, pSource, w * sizeof(uint32_t)); 
 		pDest += w * sizeof(uint32_t);
@@ -2,8 +2,15 @@
 #define __TEXTURE_H__
 
 #include <GL/gl.h>
+#include <GL/glext.h>
+#include <stdint.h>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include "pixelbufferpool.h"
 
 typedef struct SDL_Surface SDL_Surface;
+class TextureAtlas;
 
 class Texture
 {
@@ -16,13 +23,29 @@ public:
 
 	/*! \brief Converts a SDL surface
 	 *  \param pSurface Surface to convert
+	 *  \param pAtlas Atlas to place the surface in, if any
+	 *  \param bStream Convert into a pixel buffer, if one is available
 	 *  \returns true on success
 	 *
 	 *  This function will _not_ create the actual texture itself - this
 	 *  will be done on the first GetTextureID() call in the texture
-	 *  object.
+	 *  object. If requested and possible, the surface is converted into a
+	 *  pixel buffer so that the upload is left to the OpenGL implementation.
+	 *  The pixel buffer pool is sized for photo's only; everything else
+	 *  must leave bStream unset so that it doesn't take their buffers.
+	 *
+	 *  If an atlas is given and the surface fits in it, the texture becomes
+	 *  a part of the atlas instead; the normalized coordinates then describe
+	 *  where in the atlas the surface is.
+	 */
+	bool ConvertSurface(SDL_Surface* pSurface, TextureAtlas* pAtlas = NULL, bool bStream = false);
+
+	/*! \brief Calculates the memory needed to convert a surface
+	 *  \param iWidth Surface width, in pixels
+	 *  \param iHeight Surface height, in pixels
+	 *  \returns Number of bytes needed by ConvertSurface()
 	 */
-	bool ConvertSurface(SDL_Surface* pSurface);
+	static size_t CalculateDataSize(uint32_t iWidth, uint32_t iHeight);
 
 	/*! \brief Updates part of a texture
 	 *  \param pSurface Source surface to use
@@ -34,26 +57,64 @@ public:
 	 *  \param h Height to update, in pixels
 	 *
 	 *  This function will not do any conversions; the surface must be
-	 *  32-bit.
+	 *  32-bit. If nothing has been uploaded yet, only the converted data is
+	 *  updated.
 	 */
 	void Update(SDL_Surface* pSurface, int dstX, int dstY, int srcX, int srcY, int w, int h);
 
 	/*! \brief Retrieve the OpenGL texture ID
 	 *  \returns OpenGL texture ID
 	 *
-	 *  This function will create the texture as necessary; it should
-	 *  only be called from the main thread that does all OpenGL
-	 *  interactions.
+	 *  This function will create the texture as necessary and finish any
+	 *  upload still pending; it should only be called from the main thread
+	 *  that does all OpenGL interactions.
 	 */
 	GLuint GetTextureID();
 
+	/*! \brief Uploads part of the converted texture data
+	 *  \param iNumRows Maximum number of rows to upload
+	 *  \returns true if the texture is now resident
+	 *
+	 *  This creates the texture as necessary and uploads the next rows, so
+	 *  that large textures can be uploaded over multiple frames. The
+	 *  converted data is freed once everything is uploaded. This must only
+	 *  be called from the main thread or a thread attached to a
+	 *  SharedContext.
+	 */
+	bool UploadRows(int iNumRows);
+
+	/*! \brief Is the texture completely uploaded?
+	 *
+	 *  If this holds, GetTextureID() will not need to upload anything. If
+	 *  the texture was uploaded by another thread, this only holds once that
+	 *  upload has completed.
+	 */
+	bool IsResident();
+
+	//! \brief Is the texture a part of an atlas?
+	bool IsInAtlas() const { return m_pAtlasPage != NULL; }
+
+	//! \brief Is there texture data left to upload?
+	bool HasPendingUpload() const { return m_pTextureData != NULL; }
+
 	/*! \brief Unloads the texture
 	 *
 	 *  This will destroy the pending texture or the OpenGL texture, depending
-	 *  on what is loaded.
+	 *  on what is loaded. This may be called from any thread; the OpenGL
+	 *  texture is handed to the TexturePool so that it can be reused.
 	 */
 	void Unload();
 
+	//! \brief Retrieve the amount of system memory in use, in bytes
+	size_t GetSystemMemorySize() const {
+		return (m_pTextureData != NULL) ? m_iTextureWidth * m_iTextureHeight * sizeof(uint32_t) : 0;
+	}
+
+	//! \brief Retrieve the amount of video memory in use, in bytes
+	size_t GetVideoMemorySize() const {
+		return (m_iTexture != m_ciUndefinedTexture) ? m_iTextureWidth * m_iTextureHeight * sizeof(uint32_t) : 0;
+	}
+
 	//! \brief Retrieve the image height, in pixels
 	unsigned int GetHeight() const { return m_iHeight; }
 
@@ -66,22 +127,34 @@ public:
 	//! \brief Retrieve the image width, in pixels
 	unsigned int GetTextureWidth() const { return m_iTextureWidth; }
 
+	//! \brief Normalized left texture coordinate, which is 0.0f unless in an atlas
+	float GetNormalizedLeft() const { return m_fNormalizedLeft; }
+
+	//! \brief Normalized top texture coordinate, which is 0.0f unless in an atlas
+	float GetNormalizedTop() const { return m_fNormalizedTop; }
+
 	/*! \brief Normalized texture height
 	 *
-	 *  The normalized height is 1.0f; but due to constraints a texture must be a
-	 *  power of two - this means extra pixels may be added and thus we may
-	 *  need to return less than 1.0f.
+	 *  The normalized height is 1.0f; but due to constraints a texture may have
+	 *  to be a power of two - this means extra pixels may be added and thus we
+	 *  may need to return less than 1.0f.
 	 */
 	float GetNormalizedHeight() const { return m_fNormalizedHeight; }
 
 	/*! \brief Normalized texture width
 	 *
-	 *  The normalized width is 1.0f; but due to constraints a texture must be a
-	 *  power of two - this means extra pixels may be added and thus we may
-	 *  need to return less than 1.0f.
+	 *  The normalized width is 1.0f; but due to constraints a texture may have
+	 *  to be a power of two - this means extra pixels may be added and thus we
+	 *  may need to return less than 1.0f.
 	 */
 	float GetNormalizedWidth() const { return m_fNormalizedWidth; }
 
+	/*! \brief Retrieve the number of bytes saved by not padding the texture
+	 *
+	 *  This is zero unless non-power-of-two textures are supported.
+	 */
+	size_t GetPaddingSaved() const { return m_uiPaddingSaved; }
+
 
 protected:
 	/*! \brief Rounds a number up to the next power of two
@@ -91,7 +164,29 @@ protected:
 	 */
 	static uint32_t RoundUp2(uint32_t n);
 
+	//! \brief Destroys fences that were unloaded from other threads
+	static void DeleteDeferredFences();
+
+	/*! \brief May the calling thread perform OpenGL calls?
+	 *
+	 *  This is only the case for the main thread and threads attached to a
+	 *  SharedContext.
+	 */
+	static bool CanUseOpenGL();
+
 private:
+	/*
+	 * The atlas fills in the fields below to make a texture refer to its
+	 * place in an atlas page.
+	 */
+	friend class TextureAtlas;
+
+	//! \brief Normalized left coordinate within the OpenGL texture
+	float m_fNormalizedLeft;
+
+	//! \brief Normalized top coordinate within the OpenGL texture
+	float m_fNormalizedTop;
+
 	//! \brief Normalized width is the scaled width for OpenGL
 	float m_fNormalizedWidth;
 
@@ -101,6 +196,15 @@ private:
 	//! \brief Pointer to texture data, if necessary
 	uint32_t* m_pTextureData;
 
+	//! \brief Pixel buffer holding the texture data, if any
+	PixelBufferPool::Buffer* m_pPixelBuffer;
+
+	//! \brief Number of rows uploaded so far
+	int m_iUploadedRows;
+
+	//! \brief Fence to pass before using a texture uploaded by another thread
+	GLsync m_pFence;
+
 	//! \brief Original image height, in pixels
 	int m_iHeight;
 
@@ -116,15 +220,35 @@ private:
 	//! \brief Texture format
 	GLenum m_eTextureFormat;
 
+	//! \brief Bytes saved by not padding to a power of two
+	size_t m_uiPaddingSaved;
+
 	//! \brief OpenGL texture, if any
 	GLuint m_iTexture;
 
+	//! \brief Atlas page holding our contents, if any
+	Texture* m_pAtlasPage;
+
+	//! \brief Position within the atlas page, in pixels
+	int m_iAtlasX, m_iAtlasY;
+
 	/*! \brief OpenGL undefined texture ID
 	 *
 	 *  This value is used for the 'default texture' and will never be returned by
 	 *  glGenTextures() - this means it is adequate to use as a 'invalid id' value.
 	 */
 	static const GLuint m_ciUndefinedTexture = 0;
+
+	typedef std::vector<GLsync> TFenceVector;
+
+	//! \brief Fences to be deleted by the main thread
+	static TFenceVector m_oDeferredFences;
+
+	//! \brief Lock protecting m_oDeferredFences
+	static boost::mutex m_oDeferredLock;
+
+	//! \brief Thread performing all OpenGL interactions
+	static boost::thread::id m_oMainThread;
 };
 
 #endif /* __TEXTURE_H__ */
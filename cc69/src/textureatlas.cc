@@ -0,0 +1,133 @@
+#include "textureatlas.h"
+#include <assert.h>
+#include <iostream>
+#include <SDL/SDL.h>
+#include "app.h"
+
+TextureAtlas::TextureAtlas(int iPageSize)
+	: m_iPageSize(iPageSize), m_uiNumTextures(0), m_uiUsedPixels(0)
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	Unload();
+}
+
+TextureAtlas::Page*
+TextureAtlas::CreatePage()
+{
+	SDL_Surface* pSurface = SDL_CreateRGBSurface(SDL_SWSURFACE, m_iPageSize, m_iPageSize, 32, 0xff, 0xff00, 0xff0000, 0xff000000);
+	if (pSurface == NULL)
+		return NULL;
+	SDL_FillRect(pSurface, NULL, 0);
+
+	// The texture keeps its own copy of the (transparent) data until it is used
+	Page* pPage = new Page();
+	bool bConverted = pPage->m_oTexture.ConvertSurface(pSurface);
+	SDL_FreeSurface(pSurface);
+	if (!bConverted) {
+		delete pPage;
+		return NULL;
+	}
+
+	m_oPages.push_back(pPage);
+	return pPage;
+}
+
+bool
+TextureAtlas::Allocate(Page& oPage, int iWidth, int iHeight, int& iX, int& iY)
+{
+	Shelf* pBest = NULL;
+	for (TShelfVector::iterator it = oPage.m_oShelves.begin(); it != oPage.m_oShelves.end(); it++) {
+		if (it->m_iHeight < iHeight || it->m_iUsedWidth + iWidth > m_iPageSize)
+			continue;
+		if (pBest == NULL || it->m_iHeight < pBest->m_iHeight)
+			pBest = &*it;
+	}
+
+	if (pBest == NULL) {
+		// Open a new shelf below the others, if there is room left
+		if (oPage.m_iUsedHeight + iHeight > m_iPageSize)
+			return false;
+		oPage.m_oShelves.push_back(Shelf(oPage.m_iUsedHeight, iHeight));
+		oPage.m_iUsedHeight += iHeight;
+		pBest = &oPage.m_oShelves.back();
+	}
+
+	iX = pBest->m_iUsedWidth;
+	iY = pBest->m_iY;
+	pBest->m_iUsedWidth += iWidth;
+	return true;
+}
+
+bool
+TextureAtlas::Add(Texture& oTexture, SDL_Surface* pSurface)
+{
+	assert(oTexture.m_pAtlasPage == NULL);
+
+	// Pages are RGBA; surfaces in any other layout are left to the caller
+	if (pSurface->format->BytesPerPixel != 4 || pSurface->format->Rmask != 0xff)
+		return false;
+
+	int iWidth = pSurface->w + m_ciPadding;
+	int iHeight = pSurface->h + m_ciPadding;
+	if (pSurface->w <= 0 || pSurface->h <= 0 || iWidth > m_iPageSize || iHeight > m_iPageSize)
+		return false;
+
+	int iX, iY;
+	Page* pPage = NULL;
+	for (TPageVector::iterator it = m_oPages.begin(); it != m_oPages.end(); it++) {
+		if (Allocate(**it, iWidth, iHeight, iX, iY)) {
+			pPage = *it;
+			break;
+		}
+	}
+	if (pPage == NULL) {
+		pPage = CreatePage();
+		if (pPage == NULL)
+			return false;
+		if (!Allocate(*pPage, iWidth, iHeight, iX, iY))
+			assert(0);
+	}
+
+	pPage->m_oTexture.Update(pSurface, iX, iY, 0, 0, pSurface->w, pSurface->h);
+
+	// Make the texture refer to its place within the page
+	oTexture.m_pAtlasPage = &pPage->m_oTexture;
+	oTexture.m_iAtlasX = iX;
+	oTexture.m_iAtlasY = iY;
+	oTexture.m_iWidth = pSurface->w;
+	oTexture.m_iHeight = pSurface->h;
+	oTexture.m_iTextureWidth = m_iPageSize;
+	oTexture.m_iTextureHeight = m_iPageSize;
+	oTexture.m_eTextureFormat = GL_RGBA;
+	oTexture.m_uiPaddingSaved = 0;
+	oTexture.m_fNormalizedLeft = (float)iX / (float)m_iPageSize;
+	oTexture.m_fNormalizedTop = (float)iY / (float)m_iPageSize;
+	oTexture.m_fNormalizedWidth = (float)pSurface->w / (float)m_iPageSize;
+	oTexture.m_fNormalizedHeight = (float)pSurface->h / (float)m_iPageSize;
+
+	m_uiNumTextures++;
+	m_uiUsedPixels += pSurface->w * pSurface->h;
+	return true;
+}
+
+void
+TextureAtlas::Unload()
+{
+	if (m_oPages.empty())
+		return;
+
+	if (g_oApp.IsVerbose())
+		std::cerr << "TextureAtlas: " << m_uiNumTextures << " textures on " << m_oPages.size() << " pages, " <<
+		 (100 * (uint64_t)m_uiUsedPixels) / ((uint64_t)m_oPages.size() * m_iPageSize * m_iPageSize) << "% in use\n";
+
+	for (TPageVector::iterator it = m_oPages.begin(); it != m_oPages.end(); it++)
+		delete *it;
+	m_oPages.clear();
+	m_uiNumTextures = 0;
+	m_uiUsedPixels = 0;
+}
+
+/* vim:set ts=2 sw=2: */
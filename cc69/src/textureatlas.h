@@ -0,0 +1,126 @@
+#ifndef __TEXTUREATLAS_H__
+#define __TEXTUREATLAS_H__
+
+#include <vector>
+#include "texture.h"
+
+/*! \brief Packs small textures into a few large ones
+ *
+ *  Every texture added to the atlas is copied into one of its pages, which
+ *  are ordinary textures; the texture then refers to its place within that
+ *  page. Things drawn using textures from the same page need not rebind
+ *  anything, so the SpriteBatch can draw them using a single call.
+ *
+ *  Pages are packed using shelves: rows as high as the first texture put
+ *  in them, which are filled from left to right. Space is never reclaimed;
+ *  the atlas is meant to be filled once, while initializing.
+ *
+ *  The atlas must only be used by the main thread.
+ */
+class TextureAtlas
+{
+public:
+	/*! \brief Constructs an empty atlas
+	 *  \param iPageSize Width and height of every page, in pixels
+	 */
+	TextureAtlas(int iPageSize = m_ciDefaultPageSize);
+
+	//! \brief Destroys the atlas
+	~TextureAtlas();
+
+	/*! \brief Adds a surface to the atlas
+	 *  \param oTexture Texture to refer to the atlas, which must be empty
+	 *  \param pSurface Surface to add
+	 *  \returns true on success
+	 *
+	 *  This fails if the surface is too large to fit in a page, or if it
+	 *  isn't 32-bit RGBA; it should then be converted as usual.
+	 */
+	bool Add(Texture& oTexture, SDL_Surface* pSurface);
+
+	/*! \brief Throws away all pages
+	 *
+	 *  Textures in the atlas must have been unloaded before this is called.
+	 */
+	void Unload();
+
+	//! \brief Retrieve the number of pages in use
+	int GetNumPages() const { return m_oPages.size(); }
+
+private:
+	//! \brief A row of textures within a page
+	struct Shelf {
+		Shelf(int iY, int iHeight)
+		 : m_iY(iY), m_iHeight(iHeight), m_iUsedWidth(0)
+		{
+		}
+
+		//! \brief Top of the shelf, in pixels
+		int m_iY;
+
+		//! \brief Height of the shelf, in pixels
+		int m_iHeight;
+
+		//! \brief Width in use, in pixels
+		int m_iUsedWidth;
+	};
+	typedef std::vector<Shelf> TShelfVector;
+
+	//! \brief A single texture holding the contents of the atlas
+	struct Page {
+		Page() : m_iUsedHeight(0) { }
+
+		//! \brief Texture containing all surfaces on the page
+		Texture m_oTexture;
+
+		//! \brief Shelves on the page
+		TShelfVector m_oShelves;
+
+		//! \brief Height in use by the shelves, in pixels
+		int m_iUsedHeight;
+	};
+	typedef std::vector<Page*> TPageVector;
+
+	//! \brief Creates a new, transparent page
+	Page* CreatePage();
+
+	/*! \brief Finds room for a rectangle on a page
+	 *  \param oPage Page to use
+	 *  \param iWidth Width needed, in pixels
+	 *  \param iHeight Height needed, in pixels
+	 *  \param iX Receives the left position
+	 *  \param iY Receives the top position
+	 *  \returns true if the rectangle fits
+	 *
+	 *  The shelf wasting the least height is used; if it fits on none, a
+	 *  new shelf is opened.
+	 */
+	bool Allocate(Page& oPage, int iWidth, int iHeight, int& iX, int& iY);
+
+	//! \brief Pages in use
+	TPageVector m_oPages;
+
+	//! \brief Width and height of every page, in pixels
+	int m_iPageSize;
+
+	//! \brief Number of textures added
+	unsigned int m_uiNumTextures;
+
+	//! \brief Number of pixels in use by textures
+	unsigned int m_uiUsedPixels;
+
+	/*! \brief Default page size, in pixels
+	 *
+	 *  This is small enough for any OpenGL implementation we care about.
+	 */
+	static const int m_ciDefaultPageSize = 1024;
+
+	/*! \brief Transparent space kept between textures, in pixels
+	 *
+	 *  This prevents textures from picking up the edges of their neighbours
+	 *  should they ever be filtered.
+	 */
+	static const int m_ciPadding = 1;
+};
+
+#endif /* __TEXTUREATLAS_H__ */
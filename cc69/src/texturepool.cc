@@ -0,0 +1,64 @@
+#include "texturepool.h"
+#include <iostream>
+#include <vector>
+#include "app.h"
+
+TexturePool::TEntryQueue TexturePool::m_oEntries;
+boost::mutex TexturePool::m_oLock;
+unsigned int TexturePool::m_uiNumHits = 0;
+unsigned int TexturePool::m_uiNumMisses = 0;
+
+GLuint
+TexturePool::Acquire(int iWidth, int iHeight, GLenum eFormat)
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+
+	// Prefer the most recently released texture; it is most likely still in video memory
+	for (TEntryQueue::reverse_iterator it = m_oEntries.rbegin(); it != m_oEntries.rend(); it++) {
+		if (it->m_iWidth != iWidth || it->m_iHeight != iHeight || it->m_eFormat != eFormat)
+			continue;
+		GLuint iTexture = it->m_iTexture;
+		m_oEntries.erase(--(it.base()));
+		m_uiNumHits++;
+		return iTexture;
+	}
+
+	m_uiNumMisses++;
+	return 0;
+}
+
+void
+TexturePool::Release(GLuint iTexture, int iWidth, int iHeight, GLenum eFormat)
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	m_oEntries.push_back(Entry(iTexture, iWidth, iHeight, eFormat));
+}
+
+void
+TexturePool::Trim()
+{
+	std::vector<GLuint> oTextures;
+	{
+		boost::unique_lock<boost::mutex> oLock(m_oLock);
+		while (m_oEntries.size() > m_ciMaxTextures) {
+			oTextures.push_back(m_oEntries.front().m_iTexture);
+			m_oEntries.pop_front();
+		}
+	}
+	if (!oTextures.empty())
+		glDeleteTextures(oTextures.size(), &oTextures.front());
+}
+
+void
+TexturePool::Cleanup()
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	for (TEntryQueue::iterator it = m_oEntries.begin(); it != m_oEntries.end(); it++)
+		glDeleteTextures(1, &it->m_iTexture);
+	m_oEntries.clear();
+
+	if (g_oApp.IsVerbose())
+		std::cerr << "TexturePool: " << m_uiNumHits << " textures reused, " << m_uiNumMisses << " created\n";
+}
+
+/* vim:set ts=2 sw=2: */
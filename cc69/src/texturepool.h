@@ -0,0 +1,90 @@
+#ifndef __TEXTUREPOOL_H__
+#define __TEXTUREPOOL_H__
+
+#include <GL/gl.h>
+#include <deque>
+#include <boost/thread/mutex.hpp>
+
+/*! \brief Pool of OpenGL textures which are no longer in use
+ *
+ *  Rather than deleting a texture and creating a new one of the same size
+ *  for the next image, textures are handed back to the pool which will
+ *  return them for the next texture with the same size and format. The
+ *  storage can then be refilled instead of being reallocated by the
+ *  driver.
+ *
+ *  Releasing textures does not perform any OpenGL calls and may thus be
+ *  done by any thread; excess textures are destroyed by Trim().
+ */
+class TexturePool
+{
+public:
+	/*! \brief Obtains a texture from the pool
+	 *  \param iWidth Texture width, in pixels
+	 *  \param iHeight Texture height, in pixels
+	 *  \param eFormat Texture format
+	 *  \returns Texture with storage of the given size and format, or 0 if
+	 *           the pool has none
+	 */
+	static GLuint Acquire(int iWidth, int iHeight, GLenum eFormat);
+
+	/*! \brief Hands a texture back to the pool
+	 *  \param iTexture Texture to return
+	 *  \param iWidth Texture width, in pixels
+	 *  \param iHeight Texture height, in pixels
+	 *  \param eFormat Texture format
+	 */
+	static void Release(GLuint iTexture, int iWidth, int iHeight, GLenum eFormat);
+
+	/*! \brief Destroys the least recently released textures in excess
+	 *
+	 *  This must be called by a thread that can use OpenGL.
+	 */
+	static void Trim();
+
+	//! \brief Destroys all textures; must be called by the main thread
+	static void Cleanup();
+
+	//! \brief Retrieve the number of textures obtained from the pool
+	static unsigned int GetNumHits() { return m_uiNumHits; }
+
+	//! \brief Retrieve the number of textures the pool could not provide
+	static unsigned int GetNumMisses() { return m_uiNumMisses; }
+
+private:
+	//! \brief A texture which is not in use
+	struct Entry {
+		Entry(GLuint iTexture, int iWidth, int iHeight, GLenum eFormat)
+		 : m_iTexture(iTexture), m_iWidth(iWidth), m_iHeight(iHeight), m_eFormat(eFormat)
+		{
+		}
+
+		GLuint m_iTexture;
+		int m_iWidth;
+		int m_iHeight;
+		GLenum m_eFormat;
+	};
+
+	typedef std::deque<Entry> TEntryQueue;
+
+	//! \brief Textures which are not in use, least recently released first
+	static TEntryQueue m_oEntries;
+
+	//! \brief Lock protecting the pool
+	static boost::mutex m_oLock;
+
+	//! \brief Number of textures obtained from the pool
+	static unsigned int m_uiNumHits;
+
+	//! \brief Number of textures the pool could not provide
+	static unsigned int m_uiNumMisses;
+
+	/*! \brief Maximum number of textures to keep
+	 *
+	 *  Unused textures are not accounted for by the image cache; this keeps
+	 *  the pool small enough not to matter.
+	 */
+	static const unsigned int m_ciMaxTextures = 4;
+};
+
+#endif /* __TEXTUREPOOL_H__ */
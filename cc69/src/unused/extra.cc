@@ -26,16 +26,7 @@ Extra::Init()
 	m_fRx = 0.0f;
 	m_fRy = 0.0f;
 	m_fRz = 0.0f;
-}
-
-void
-Extra::Cleanup()
-{
-}
 
-void
-Extra::Run()
-{
 	glMatrixMode(GL_PROJECTION);
   glLoadIdentity();
 
@@ -56,11 +47,17 @@ Extra::Run()
   glLoadIdentity();
 
 	m_bLeaving = false;
-	while(!m_bLeaving) {
-		HandleEvents();
-		Render();
-		SDL_Delay(1000 / g_oApp.GetDesiredFPS());
-	}
+}
+
+void
+Extra::Cleanup()
+{
+}
+
+void
+Extra::Update(float /* fStep */)
+{
+	HandleEvents();
 }
 
 void
@@ -91,7 +88,7 @@ Extra::HandleEvents()
 }
 
 void
-Extra::Render()
+Extra::Render(float /* fAlpha */)
 {
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -122,8 +119,6 @@ Extra::Render()
 		glVertex3f(x, y, z);
 	}
 	glEnd();
-
-	SDL_GL_SwapBuffers();
 }
 
 /* vim:set ts=2 sw=2: */
@@ -11,11 +11,12 @@ public:
 
 	virtual void Init();
 	virtual void Cleanup();
-	virtual void Run();
+	virtual void Update(float fStep);
+	virtual void Render(float fAlpha);
+	virtual bool IsFinished() { return m_bLeaving; }
 
 protected:
 	void HandleEvents();
-	void Render();
 
 	//! \brief Are we there yet?
 	bool m_bLeaving;
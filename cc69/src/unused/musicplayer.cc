@@ -37,6 +37,29 @@ MusicPlayer::Init()
 	m_fX = 0.0f;
 	m_fY = 0.0f;
 	m_fZ = -600.0f;
+
+	glMatrixMode(GL_PROJECTION);
+  glLoadIdentity();
+
+	/*
+	 * Create our viewing frustrum; this is based on OpenGL transformation FAQ
+	 * entry 9.085 'How can I make a call to glFrustum() that matches my call to
+	 * gluPerspective()?'.
+	 */
+	float fov = 45.0f;
+	float fNear = 10.0f;
+	float fFar = 2000.0f;
+	float fAspect = (float)g_oApp.GetScreenWidth() / (float)g_oApp.GetScreenHeight();
+
+	float fTop = tan(fov * M_PI / 360.0f) * fNear;
+	glFrustum(fAspect * -fTop, fAspect * fTop, -fTop, fTop, fNear, fFar);
+
+  glMatrixMode(GL_MODELVIEW);
+  glLoadIdentity();
+
+	Mix_PlayMusic(m_pMusic, 1);
+	Mix_VolumeMusic(SDL_MIX_MAXVOLUME);
+	m_bLeaving = false;
 }
 
 void
@@ -94,34 +117,9 @@ MusicPlayer::PostMix(Uint8* pStream, int iLength)
 }
 
 void
-MusicPlayer::Run()
+MusicPlayer::Update(float /* fStep */)
 {
-	glMatrixMode(GL_PROJECTION);
-  glLoadIdentity();
-
-	/*
-	 * Create our viewing frustrum; this is based on OpenGL transformation FAQ
-	 * entry 9.085 'How can I make a call to glFrustum() that matches my call to
-	 * gluPerspective()?'.
-	 */
-	float fov = 45.0f;
-	float fNear = 10.0f;
-	float fFar = 2000.0f;
-	float fAspect = (float)g_oApp.GetScreenWidth() / (float)g_oApp.GetScreenHeight();
-
-	float fTop = tan(fov * M_PI / 360.0f) * fNear;
-	glFrustum(fAspect * -fTop, fAspect * fTop, -fTop, fTop, fNear, fFar);
-
-  glMatrixMode(GL_MODELVIEW);
-  glLoadIdentity();
-
-	Mix_PlayMusic(m_pMusic, 1);
-	Mix_VolumeMusic(SDL_MIX_MAXVOLUME);
-	while(!m_bLeaving) {
-		HandleEvents();
-		Render();
-	//	SDL_Delay(1000 / g_oApp.GetDesiredFPS());
-	}
+	HandleEvents();
 }
 
 void
@@ -148,7 +146,7 @@ MusicPlayer::HandleEvents()
 }
 
 void
-MusicPlayer::Render()
+MusicPlayer::Render(float /* fAlpha */)
 {
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -247,8 +245,6 @@ MusicPlayer::Render()
 #endif
 	
 	glEnd();
-
-	SDL_GL_SwapBuffers();
 }
 
 /* vim:set ts=2 sw=2: */
@@ -14,7 +14,9 @@ public:
 
 	virtual void Init();
 	virtual void Cleanup();
-	virtual void Run();
+	virtual void Update(float fStep);
+	virtual void Render(float fAlpha);
+	virtual bool IsFinished() { return m_bLeaving; }
 
 protected:
 	static void PostMixWrapper(void* pUser, Uint8* pStream, int iLength) {
@@ -23,7 +25,6 @@ protected:
 	void PostMix(Uint8* pStream, int iLength);
 
 	void HandleEvents();
-	void Render();
 
 	//! \brief Number of mixer values
 	static const int m_ciNumValues = 100;
@@ -0,0 +1,110 @@
+#include "uploadscheduler.h"
+#include <algorithm>
+#include <iostream>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include "app.h"
+#include "image.h"
+#include "imagelibrary.h"
+#include "pixelbufferpool.h"
+
+UploadScheduler::UploadScheduler(int iBudget)
+	: m_iBudget(iBudget), m_uiNumUploaded(0), m_uiNumCutoffs(0)
+{
+}
+
+UploadScheduler::~UploadScheduler()
+{
+	if (g_oApp.IsVerbose())
+		std::cerr << "UploadScheduler: uploaded " << m_uiNumUploaded << " images, " <<
+		 m_uiNumCutoffs << " frames hit the " << m_iBudget << "us budget\n";
+}
+
+void
+UploadScheduler::Queue(Image* pImage, bool bUrgent /* = false */)
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	TImageQueue::iterator it = std::find(m_oQueue.begin(), m_oQueue.end(), pImage);
+	if (it != m_oQueue.end()) {
+		if (!bUrgent)
+			return;
+		m_oQueue.erase(it);
+	}
+	if (bUrgent)
+		m_oQueue.push_front(pImage);
+	else
+		m_oQueue.push_back(pImage);
+}
+
+bool
+UploadScheduler::IsEmpty()
+{
+	boost::unique_lock<boost::mutex> oLock(m_oLock);
+	return m_oQueue.empty();
+}
+
+void
+UploadScheduler::Process()
+{
+	// Buffers released by the decode workers can be reused from here on
+	PixelBufferPool::Replenish();
+
+	boost::posix_time::ptime oStart = boost::posix_time::microsec_clock::universal_time();
+	boost::posix_time::time_duration oBudget = boost::posix_time::microseconds(m_iBudget);
+
+	/*
+	 * Every image currently queued is tried at most once; this prevents us
+	 * from spinning on images that are locked by the decode workers.
+	 */
+	size_t uiNumAttempts;
+	{
+		boost::unique_lock<boost::mutex> oLock(m_oLock);
+		uiNumAttempts = m_oQueue.size();
+	}
+	while (uiNumAttempts-- > 0) {
+		if (boost::posix_time::microsec_clock::universal_time() - oStart >= oBudget) {
+			m_uiNumCutoffs++;
+			break;
+		}
+
+		Image* pImage;
+		{
+			boost::unique_lock<boost::mutex> oLock(m_oLock);
+			if (m_oQueue.empty())
+				break;
+			pImage = m_oQueue.front();
+			m_oQueue.pop_front();
+		}
+
+		if (!pImage->TryLock()) {
+			// Busy; try it again later
+			boost::unique_lock<boost::mutex> oLock(m_oLock);
+			m_oQueue.push_back(pImage);
+			continue;
+		}
+
+		// Images that were thrown away or are already uploaded can be skipped
+		if (!pImage->IsLoaded() || !pImage->HasPendingUpload()) {
+			pImage->Unlock();
+			continue;
+		}
+
+		bool bResident;
+		do {
+			bResident = pImage->UploadRows(m_ciRowsPerStrip);
+		} while (!bResident && boost::posix_time::microsec_clock::universal_time() - oStart < oBudget);
+
+		// Part of the image moved to video memory; the cache must know
+		g_oApp.GetImageLibrary().UpdateMemoryUsage(pImage);
+		pImage->Unlock();
+
+		if (bResident) {
+			m_uiNumUploaded++;
+		} else {
+			// Out of time; continue with this image next frame
+			boost::unique_lock<boost::mutex> oLock(m_oLock);
+			m_oQueue.push_front(pImage);
+		}
+	}
+}
+
+/* vim:set ts=2 sw=2: */
@@ -0,0 +1,70 @@
+#ifndef __UPLOADSCHEDULER_H__
+#define __UPLOADSCHEDULER_H__
+
+#include <deque>
+#include <boost/thread/mutex.hpp>
+
+class Image;
+
+/*! \brief Uploads decoded images to the GPU in the background
+ *
+ *  Uploading a complete photo at once may take longer than a frame lasts;
+ *  the scheduler instead uploads images in strips of rows, spending at most
+ *  a fixed amount of time per frame doing so. Images can be queued by any
+ *  thread; the uploading itself is done by the main thread.
+ */
+class UploadScheduler
+{
+public:
+	/*! \brief Constructs the upload scheduler
+	 *  \param iBudget Time that may be spent uploading per frame, in microseconds
+	 */
+	UploadScheduler(int iBudget);
+
+	//! \brief Destroys the upload scheduler
+	~UploadScheduler();
+
+	/*! \brief Queues an image for uploading
+	 *  \param pImage Image to upload
+	 *  \param bUrgent If true, the image is uploaded before anything else
+	 *
+	 *  Images that are already queued are not queued again, but will be
+	 *  moved to the front if bUrgent is set.
+	 */
+	void Queue(Image* pImage, bool bUrgent = false);
+
+	/*! \brief Uploads queued images until the frame budget is spent
+	 *
+	 *  This must be called once per frame by the main thread; the
+	 *  FrameScheduler does so whether or not a frame is rendered. Images
+	 *  that are locked by someone else are skipped; images that were
+	 *  unloaded in the meantime are dropped.
+	 */
+	void Process();
+
+	//! \brief Is there nothing left to upload?
+	bool IsEmpty();
+
+private:
+	typedef std::deque<Image*> TImageQueue;
+
+	//! \brief Images waiting to be uploaded, in order
+	TImageQueue m_oQueue;
+
+	//! \brief Lock protecting m_oQueue
+	boost::mutex m_oLock;
+
+	//! \brief Time that may be spent per frame, in microseconds
+	int m_iBudget;
+
+	//! \brief Number of images completely uploaded
+	unsigned int m_uiNumUploaded;
+
+	//! \brief Number of frames in which uploading was cut off by the budget
+	unsigned int m_uiNumCutoffs;
+
+	//! \brief Number of rows to upload at once
+	static const int m_ciRowsPerStrip = 64;
+};
+
+#endif /* __UPLOADSCHEDULER_H__ */
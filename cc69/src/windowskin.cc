@@ -0,0 +1,72 @@
+#include "windowskin.h"
+#include <SDL/SDL.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <algorithm>
+#include "app.h"
+#include "spritebatch.h"
+
+bool
+WindowSkin::Create()
+{
+	/*
+	 * The skin is a window whose corners are quarter circles of m_ciRadius
+	 * pixels, with a single pixel row and column in between that is stretched
+	 * to any size.
+	 */
+	const int iSize = 2 * m_ciRadius + 1;
+	SDL_Surface* pSurface = SDL_CreateRGBSurface(SDL_SWSURFACE, iSize, iSize, 32, 0xff, 0xff00, 0xff0000, 0xff000000);
+	assert(pSurface != NULL);
+
+	SDL_LockSurface(pSurface);
+	for (int y = 0; y < iSize; y++) {
+		uint32_t* pRow = (uint32_t*)((uint8_t*)pSurface->pixels + y * pSurface->pitch);
+		for (int x = 0; x < iSize; x++) {
+			// Distance from the pixel center to the center of its corner circle
+			float fDX = std::max(0.0f, abs(x - m_ciRadius) - 0.5f);
+			float fDY = std::max(0.0f, abs(y - m_ciRadius) - 0.5f);
+			pRow[x] = (fDX * fDX + fDY * fDY <= (float)(m_ciRadius * m_ciRadius)) ? m_ciColor : 0;
+		}
+	}
+	SDL_UnlockSurface(pSurface);
+
+	bool bResult = m_oTexture.ConvertSurface(pSurface);
+	SDL_FreeSurface(pSurface);
+	return bResult;
+}
+
+void
+WindowSkin::Draw(float fLeft, float fTop, float fRight, float fBottom, float fRadius, float fDepth)
+{
+	// Corners can be no larger than half the window
+	fRadius = std::min(fRadius, std::min(fRight - fLeft, fBottom - fTop) / 2.0f);
+
+	/*
+	 * Slice boundaries on screen and within the texture; the center slice
+	 * samples the middle of the stretched pixel so that filtering doesn't
+	 * mix in the corners.
+	 */
+	const float afX[4] = { fLeft, fLeft + fRadius, fRight - fRadius, fRight };
+	const float afY[4] = { fTop, fTop + fRadius, fBottom - fRadius, fBottom };
+	const float fSize = 2.0f * m_ciRadius + 1.0f;
+	const float afTex[4] = {
+		0.0f, (m_ciRadius + 0.5f) / fSize, (m_ciRadius + 0.5f) / fSize, 1.0f
+	};
+	float fTexLeft = m_oTexture.GetNormalizedLeft(), fTexWidth = m_oTexture.GetNormalizedWidth();
+	float fTexTop = m_oTexture.GetNormalizedTop(), fTexHeight = m_oTexture.GetNormalizedHeight();
+
+	SpriteBatch& oBatch = g_oApp.GetSpriteBatch();
+	SpriteBatch::Blend oBlend(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLuint iTexture = m_oTexture.GetTextureID();
+	for (int y = 0; y < 3; y++)
+		for (int x = 0; x < 3; x++) {
+			if (afX[x] >= afX[x + 1] || afY[y] >= afY[y + 1])
+				continue;
+			oBatch.AddRect(iTexture, oBlend,
+			 afX[x], afY[y], afX[x + 1], afY[y + 1], fDepth,
+			 fTexLeft + afTex[x] * fTexWidth, fTexTop + afTex[y] * fTexHeight,
+			 fTexLeft + afTex[x + 1] * fTexWidth, fTexTop + afTex[y + 1] * fTexHeight);
+		}
+}
+
+/* vim:set ts=2 sw=2: */
@@ -0,0 +1,42 @@
+#ifndef __WINDOWSKIN_H__
+#define __WINDOWSKIN_H__
+
+#include "texture.h"
+
+/*! \brief Draws translucent windows with rounded corners
+ *
+ *  All windows share a single small texture holding a window with rounded
+ *  corners, which is drawn as nine quads: the corners are scaled to the
+ *  radius wanted and the edges and center are stretched to fill the rest.
+ *  Windows thus need no texture or surface of their own.
+ */
+class WindowSkin
+{
+public:
+	/*! \brief Creates the skin texture
+	 *  \returns true on success
+	 */
+	bool Create();
+
+	/*! \brief Adds a window to the sprite batch
+	 *  \param fLeft Left screen coordinate
+	 *  \param fTop Top screen coordinate
+	 *  \param fRight Right screen coordinate
+	 *  \param fBottom Bottom screen coordinate
+	 *  \param fRadius Radius of the corners
+	 *  \param fDepth Depth, where higher values are closer to the viewer
+	 */
+	void Draw(float fLeft, float fTop, float fRight, float fBottom, float fRadius, float fDepth);
+
+private:
+	//! \brief Skin texture
+	Texture m_oTexture;
+
+	//! \brief Radius of the corners within the texture
+	static const int m_ciRadius = 16;
+
+	//! \brief Window color, as 0xAABBGGRR
+	static const unsigned int m_ciColor = 0x80909090;
+};
+
+#endif /* __WINDOWSKIN_H__ */